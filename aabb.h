@@ -0,0 +1,12 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include <glm/glm.hpp>
+
+// Axis aligned box in the play field plane.
+struct Aabb {
+  glm::vec2 min{0.0f};
+  glm::vec2 max{0.0f};
+};
+
+#endif // AABB_H
@@ -0,0 +1,246 @@
+#include "glad.h"
+
+#include "assetregistry.h"
+#include "meshcache.h"
+#include "meshoptimizer.h"
+#include "threadpool.h"
+#include "vertexpacking.h"
+#include "wavefrontreader.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+const char *programCacheDir = "shadercache";
+
+// FNV-1a over all strings including their terminators, so moving text
+// between the sources changes the hash
+uint64_t hashSources(std::initializer_list<const char *> sources) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const char *source : sources) {
+    size_t length = std::strlen(source) + 1;
+    for (size_t n = 0; n < length; n++) {
+      hash ^= (unsigned char)source[n];
+      hash *= 0x100000001b3ull;
+    }
+  }
+  return hash;
+}
+
+bool hasProgramBinaryFormats() {
+  int formats{0};
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  return formats > 0;
+}
+} // namespace
+
+AssetRegistry::AssetRegistry() {}
+
+uint32_t AssetRegistry::loadMesh(const std::string &filename) {
+  auto found = m_meshIds.find(filename);
+  if (found != m_meshIds.end()) {
+    return found->second;
+  }
+
+  MeshAsset asset;
+  auto cacheFilename = meshCacheName(filename);
+  if (m_verbose || !meshCacheIsFresh(filename, cacheFilename) ||
+      !loadCompiled(filename, cacheFilename, asset)) {
+    loadObj(filename, cacheFilename, asset);
+  }
+
+  uint32_t meshId = m_meshes.size();
+  m_meshes.push_back(std::move(asset));
+  m_meshIds[filename] = meshId;
+
+  return meshId;
+}
+
+const MeshAsset &AssetRegistry::mesh(uint32_t meshId) const {
+  return m_meshes[meshId];
+}
+
+uint32_t AssetRegistry::loadProgram(const char *vertexSource,
+                                    const char *fragmentSource,
+                                    const char *defines) {
+  uint64_t hash = hashSources({vertexSource, fragmentSource, defines});
+  auto found = m_programIds.find(hash);
+  if (found != m_programIds.end()) {
+    return found->second;
+  }
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+  auto binaryFilename = (std::filesystem::path(programCacheDir) / name).string();
+  bool persist = hasProgramBinaryFormats();
+
+  ShaderProgram program;
+  if (!persist || !program.loadBinary(binaryFilename)) {
+    bool linked = program.build(vertexSource, fragmentSource, defines);
+    if (persist && linked) {
+      std::error_code error;
+      std::filesystem::create_directories(programCacheDir, error);
+      program.saveBinary(binaryFilename);
+    }
+  }
+
+  uint32_t programId = m_programs.size();
+  m_programs.push_back(std::move(program));
+  m_programIds[hash] = programId;
+
+  return programId;
+}
+
+const ShaderProgram &AssetRegistry::program(uint32_t programId) const {
+  return m_programs[programId];
+}
+
+void AssetRegistry::release() {
+  for (auto &arena : m_arenas) {
+    arena.release();
+  }
+  m_arenas.clear();
+  m_meshes.clear();
+  m_meshIds.clear();
+
+  for (auto &program : m_programs) {
+    program.release();
+  }
+  m_programs.clear();
+  m_programIds.clear();
+}
+
+bool AssetRegistry::loadCompiled(const std::string &filename,
+                                 const std::string &cacheFilename,
+                                 MeshAsset &asset) {
+  MeshCacheFile cache(cacheFilename);
+  if (!cache.isValid()) {
+    return false;
+  }
+
+  const auto &header = cache.header();
+  bool optimized = (header.flags & MeshCacheOptimized) != 0;
+  if (optimized != m_optimizeMeshes) {
+    return false;
+  }
+
+  asset.boundsMin = header.boundsMin;
+  asset.boundsMax = header.boundsMax;
+  asset.width = header.width;
+  asset.height = header.height;
+  // straight from the mapped file into the GL buffers
+  upload(filename, asset, cache.vertices(), header.vertexCount,
+         cache.indicies(), header.indexCount, header.indexSize);
+
+  return true;
+}
+
+void AssetRegistry::loadObj(const std::string &filename,
+                            const std::string &cacheFilename,
+                            MeshAsset &asset) {
+  Mesh mesh;
+  WaveFrontReader reader(filename);
+  // files big enough to split are parsed on a pool that only lives for
+  // this load, the game keeps no idle threads around for its assets
+  std::error_code error;
+  auto size = std::filesystem::file_size(filename, error);
+  if (!error && size >= 2 * WaveFrontReader::minChunkSize) {
+    ThreadPool pool;
+    reader.readVertices(mesh, pool);
+  } else {
+    reader.readVertices(mesh);
+  }
+
+  uint32_t flags{0};
+  if (m_optimizeMeshes && !mesh.indicies.empty()) {
+    VertexCacheStats before;
+    if (m_verbose) {
+      before = analyzeVertexCache(mesh);
+    }
+    optimizeMesh(mesh);
+    flags |= MeshCacheOptimized;
+    if (m_verbose) {
+      reportVertexCache(filename, before, analyzeVertexCache(mesh));
+    }
+  }
+  compactIndicies(mesh);
+
+  if (!mesh.vertices.empty()) {
+    writeMeshCache(cacheFilename, mesh, flags);
+  }
+
+  asset.boundsMin = mesh.boundsMin;
+  asset.boundsMax = mesh.boundsMax;
+  asset.width = mesh.width;
+  asset.height = mesh.height;
+  if (!mesh.shortIndicies.empty()) {
+    upload(filename, asset, mesh.vertices.data(), mesh.vertices.size(),
+           mesh.shortIndicies.data(), mesh.shortIndicies.size(),
+           sizeof(uint16_t));
+  } else {
+    upload(filename, asset, mesh.vertices.data(), mesh.vertices.size(),
+           mesh.indicies.data(), mesh.indicies.size(), sizeof(uint32_t));
+  }
+}
+
+void AssetRegistry::upload(const std::string &filename, MeshAsset &asset,
+                           const Vertex *vertices, uint32_t vertexCount,
+                           const void *indicies, uint32_t indexCount,
+                           uint32_t indexSize) {
+  asset.vertexCount = vertexCount;
+  asset.indexCount = indexCount;
+  asset.indexType =
+      indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+  if (vertexCount == 0 || indexCount == 0) {
+    return;
+  }
+
+  auto &target = arena(m_vertexFormat, indexSize);
+  asset.VAO = target.VAO();
+  if (m_vertexFormat != VertexFormat::Packed) {
+    target.append(vertices, vertexCount, indicies, indexCount,
+                  asset.baseVertex, asset.firstIndex);
+    return;
+  }
+
+  auto packed = packVertices(vertices, vertexCount, asset.boundsMin,
+                             asset.boundsMax);
+  if (m_verbose) {
+    reportQuantization(filename,
+                       measureQuantization(vertices, packed.data(), vertexCount,
+                                           asset.boundsMin, asset.boundsMax));
+  }
+
+  asset.format = VertexFormat::Packed;
+  asset.dequantize = dequantizeMatrix(asset.boundsMin, asset.boundsMax);
+  target.append(packed.data(), vertexCount, indicies, indexCount,
+                asset.baseVertex, asset.firstIndex);
+}
+
+// meshes sharing vertex format and index size share one arena
+MeshArena &AssetRegistry::arena(VertexFormat format, uint32_t indexSize) {
+  for (auto &arena : m_arenas) {
+    if (arena.format() == format && arena.indexSize() == indexSize) {
+      return arena;
+    }
+  }
+  m_arenas.emplace_back();
+  m_arenas.back().setup(format, indexSize);
+  return m_arenas.back();
+}
+
+void AssetRegistry::reportVertexCache(const std::string &filename,
+                                      const VertexCacheStats &before,
+                                      const VertexCacheStats &after) {
+  std::cout << filename << " ACMR " << before.acmr << " -> " << after.acmr
+            << " ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+}
+
+void AssetRegistry::reportQuantization(const std::string &filename,
+                                       const QuantizationError &error) {
+  std::cout << filename << " packed vertex error: position " << error.position
+            << " normal " << error.normalDegrees << " deg uv "
+            << error.textureCoords << std::endl;
+}
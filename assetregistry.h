@@ -0,0 +1,85 @@
+#ifndef ASSETREGISTRY_H
+#define ASSETREGISTRY_H
+
+#include "mesh.h"
+#include "mesharena.h"
+#include "meshoptimizer.h"
+#include "shaderprogram.h"
+#include "vertexpacking.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+// A mesh loaded once together with where it lives on the GPU. Only the
+// metadata is kept on the CPU side, vertex data lives in a shared MeshArena.
+struct MeshAsset {
+  glm::vec3 boundsMin{0.0f};
+  glm::vec3 boundsMax{0.0f};
+  float width{0};
+  float height{0};
+  VertexFormat format{VertexFormat::Float};
+  // maps packed positions back to model space, identity for Float
+  glm::mat4 dequantize{1.0f};
+  uint32_t vertexCount{0};
+  uint32_t indexCount{0};
+  uint32_t indexType{0}; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+  uint32_t VAO{0};       // of the arena holding the mesh
+  uint32_t firstIndex{0};
+  int32_t baseVertex{0};
+};
+
+// Owns every mesh asset and shader program, game objects only keep the
+// returned ids so objects sharing a model (like all the blocks) share one
+// copy of it. References returned by mesh() and program() stay valid while
+// more assets are loaded.
+class AssetRegistry {
+public:
+  AssetRegistry();
+
+  // reorder meshes for the vertex cache when they are parsed, on by default
+  void setOptimizeMeshes(bool optimize) { m_optimizeMeshes = optimize; }
+  // GPU vertex layout used for meshes loaded after this call
+  void setVertexFormat(VertexFormat format) { m_vertexFormat = format; }
+  // prints mesh diagnostics while loading, off by default since they cost
+  // extra passes over every mesh. Meshes are then always parsed from their
+  // .obj, so the vertex cache report is printed even with a fresh .mesh.
+  void setVerbose(bool verbose) { m_verbose = verbose; }
+
+  uint32_t loadMesh(const std::string &filename);
+  const MeshAsset &mesh(uint32_t meshId) const;
+
+  // identical sources share one program, linked programs are kept as
+  // program binaries in shadercache/ so later runs skip compiling
+  uint32_t loadProgram(const char *vertexSource, const char *fragmentSource,
+                       const char *defines = "");
+  const ShaderProgram &program(uint32_t programId) const;
+
+  void release();
+
+private:
+  bool loadCompiled(const std::string &filename,
+                    const std::string &cacheFilename, MeshAsset &asset);
+  void loadObj(const std::string &filename, const std::string &cacheFilename,
+               MeshAsset &asset);
+  void upload(const std::string &filename, MeshAsset &asset,
+              const Vertex *vertices, uint32_t vertexCount,
+              const void *indicies, uint32_t indexCount, uint32_t indexSize);
+  MeshArena &arena(VertexFormat format, uint32_t indexSize);
+  static void reportVertexCache(const std::string &filename,
+                                const VertexCacheStats &before,
+                                const VertexCacheStats &after);
+  static void reportQuantization(const std::string &filename,
+                                const QuantizationError &error);
+
+  std::deque<MeshArena> m_arenas;
+  std::deque<MeshAsset> m_meshes;
+  std::deque<ShaderProgram> m_programs;
+  std::unordered_map<uint64_t, uint32_t> m_programIds;
+  std::unordered_map<std::string, uint32_t> m_meshIds;
+  bool m_optimizeMeshes{true};
+  VertexFormat m_vertexFormat{VertexFormat::Float};
+  bool m_verbose{false};
+};
+
+#endif // ASSETREGISTRY_H
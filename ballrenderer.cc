@@ -0,0 +1,41 @@
+#include "ballrenderer.h"
+#include "transform.h"
+
+BallRenderer::BallRenderer() {}
+
+void BallRenderer::setup(const AssetRegistry &assets,
+                         const GameObject &ballTemplate) {
+  m_template = ballTemplate;
+  m_local = assets.mesh(ballTemplate.meshId).dequantize;
+}
+
+void BallRenderer::submit(RenderQueue &queue, const BallSystem &balls,
+                          float alpha, JobSystem &jobs, Job *parent) {
+  if (balls.size() == 0) {
+    return;
+  }
+  uint32_t baseInstance;
+  glm::mat4 *instances = queue.allocateInstances(balls.size(), baseInstance);
+  if (instances == nullptr) {
+    return;
+  }
+
+  jobs.runRanges(
+      balls.size(), fillGrain, parent,
+      [this, &balls, alpha, instances](size_t first, size_t last) {
+        glm::vec3 movement = m_template.movement;
+        for (size_t n = first; n < last; n++) {
+          glm::vec2 position =
+              glm::mix(balls.previous(n), balls.position(n), alpha);
+          movement.x = position.x;
+          movement.y = position.y;
+          instances[n] = Transform::build(movement, m_template.rotation,
+                                          m_template.scale, m_local);
+        }
+      });
+
+  // all balls share the plane of the template, one depth stands for all
+  queue.submitInstanced(m_template.programId, m_template.textureId,
+                        m_template.meshId, balls.size(), baseInstance,
+                        queue.depth(m_template.movement));
+}
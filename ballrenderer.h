@@ -0,0 +1,34 @@
+#ifndef BALLRENDERER_H
+#define BALLRENDERER_H
+
+#include "assetregistry.h"
+#include "ballsystem.h"
+#include "gameobject.h"
+#include "jobsystem.h"
+#include "renderqueue.h"
+#include <cstddef>
+#include <cstdint>
+
+// Submits every ball of a BallSystem as one instanced draw packet. The
+// matrices are blended between the last two ticks and written by jobs,
+// balls move every tick so nothing is cached between frames.
+class BallRenderer {
+public:
+  // matrices one job builds
+  static constexpr size_t fillGrain = 4096;
+
+  BallRenderer();
+
+  // ballTemplate gives mesh, texture, program, scale and depth of the balls
+  void setup(const AssetRegistry &assets, const GameObject &ballTemplate);
+  // every ball matrix is built by a child job of parent, the packet is
+  // queued at once but must not be flushed before parent has finished
+  void submit(RenderQueue &queue, const BallSystem &balls, float alpha,
+              JobSystem &jobs, Job *parent);
+
+private:
+  GameObject m_template;
+  glm::mat4 m_local{1.0f};
+};
+
+#endif // BALLRENDERER_H
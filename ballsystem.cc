@@ -0,0 +1,231 @@
+#include "ballsystem.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+BallSystem::BallSystem() {}
+
+void BallSystem::setup(float radius, const Aabb &field) {
+  m_radius = radius;
+  m_field = field;
+  clear();
+}
+
+uint32_t BallSystem::add(glm::vec2 position, glm::vec2 velocity) {
+  uint32_t ball = m_count++;
+  if (ball % laneWidth == 0) {
+    // grow by a full lane of resting balls in the middle of the field
+    size_t padded = ball + laneWidth;
+    glm::vec2 centre = (m_field.min + m_field.max) * 0.5f;
+    m_x.resize(padded, centre.x);
+    m_y.resize(padded, centre.y);
+    m_velocityX.resize(padded, 0.0f);
+    m_velocityY.resize(padded, 0.0f);
+    m_previousX.resize(padded, centre.x);
+    m_previousY.resize(padded, centre.y);
+  }
+  m_x[ball] = m_previousX[ball] = position.x;
+  m_y[ball] = m_previousY[ball] = position.y;
+  m_velocityX[ball] = velocity.x;
+  m_velocityY[ball] = velocity.y;
+  return ball;
+}
+
+void BallSystem::clear() {
+  m_x.clear();
+  m_y.clear();
+  m_velocityX.clear();
+  m_velocityY.clear();
+  m_previousX.clear();
+  m_previousY.clear();
+  m_count = 0;
+}
+
+void BallSystem::update(const CollisionWorld &world,
+                        const std::vector<Aabb> &obstacles, float dt,
+                        std::vector<uint32_t> &hits) {
+  m_previousX = m_x;
+  m_previousY = m_y;
+  m_slow.clear();
+  advance(obstacles, dt, 0, m_count, m_slow);
+
+  for (auto ball : m_slow) {
+    glm::vec2 position(m_x[ball], m_y[ball]);
+    glm::vec2 velocity(m_velocityX[ball], m_velocityY[ball]);
+    world.moveBall(position, velocity, m_radius, dt, hits);
+    m_x[ball] = position.x;
+    m_y[ball] = position.y;
+    m_velocityX[ball] = velocity.x;
+    m_velocityY[ball] = velocity.y;
+  }
+}
+
+void BallSystem::update(const CollisionWorld &world,
+                        const std::vector<Aabb> &obstacles, float dt,
+                        std::vector<uint32_t> &hits, JobSystem &jobs) {
+  if (m_count <= updateGrain || jobs.size() == 1) {
+    update(world, obstacles, dt, hits);
+    return;
+  }
+  m_previousX = m_x;
+  m_previousY = m_y;
+  m_ranges.resize((m_count + updateGrain - 1) / updateGrain);
+
+  Job *root = jobs.create(nullptr);
+  jobs.runRanges(
+      m_count, updateGrain, root,
+      [this, &world, &obstacles, dt](size_t first, size_t last) {
+        auto &range = m_ranges[first / updateGrain];
+        range.slow.clear();
+        range.hits.clear();
+        advance(obstacles, dt, first, last, range.slow);
+        for (auto ball : range.slow) {
+          glm::vec2 position(m_x[ball], m_y[ball]);
+          glm::vec2 velocity(m_velocityX[ball], m_velocityY[ball]);
+          world.moveBallShared(position, velocity, m_radius, dt, range.hits,
+                               range.candidates);
+          m_x[ball] = position.x;
+          m_y[ball] = position.y;
+          m_velocityX[ball] = velocity.x;
+          m_velocityY[ball] = velocity.y;
+        }
+      });
+  jobs.run(root);
+  jobs.wait(root);
+
+  // in ball order, like the single threaded update
+  for (const auto &range : m_ranges) {
+    hits.insert(hits.end(), range.hits.begin(), range.hits.end());
+  }
+}
+
+// A ball is left for moveBall when its end point is outside of the walls
+// grown by the radius, or the bounds of its move touch an obstacle. first
+// is a multiple of laneWidth, the lanes past m_count are padding.
+void BallSystem::advance(const std::vector<Aabb> &obstacles, float dt,
+                         uint32_t first, uint32_t last,
+                         std::vector<uint32_t> &slow) {
+  glm::vec2 low = m_field.min + glm::vec2(m_radius);
+  glm::vec2 high = m_field.max - glm::vec2(m_radius);
+#if defined(__AVX2__)
+  const __m256 step = _mm256_set1_ps(dt);
+  const __m256 radius = _mm256_set1_ps(m_radius);
+  const __m256 lowX = _mm256_set1_ps(low.x);
+  const __m256 lowY = _mm256_set1_ps(low.y);
+  const __m256 highX = _mm256_set1_ps(high.x);
+  const __m256 highY = _mm256_set1_ps(high.y);
+
+  for (uint32_t lane = first; lane < last; lane += 8) {
+    __m256 x = _mm256_loadu_ps(&m_x[lane]);
+    __m256 y = _mm256_loadu_ps(&m_y[lane]);
+    __m256 velocityX = _mm256_loadu_ps(&m_velocityX[lane]);
+    __m256 velocityY = _mm256_loadu_ps(&m_velocityY[lane]);
+    __m256 endX = _mm256_add_ps(x, _mm256_mul_ps(velocityX, step));
+    __m256 endY = _mm256_add_ps(y, _mm256_mul_ps(velocityY, step));
+    __m256 slowLanes = _mm256_or_ps(
+        _mm256_or_ps(_mm256_cmp_ps(endX, lowX, _CMP_LT_OQ),
+                     _mm256_cmp_ps(endX, highX, _CMP_GT_OQ)),
+        _mm256_or_ps(_mm256_cmp_ps(endY, lowY, _CMP_LT_OQ),
+                     _mm256_cmp_ps(endY, highY, _CMP_GT_OQ)));
+
+    __m256 minX = _mm256_sub_ps(_mm256_min_ps(x, endX), radius);
+    __m256 minY = _mm256_sub_ps(_mm256_min_ps(y, endY), radius);
+    __m256 maxX = _mm256_add_ps(_mm256_max_ps(x, endX), radius);
+    __m256 maxY = _mm256_add_ps(_mm256_max_ps(y, endY), radius);
+    for (const auto &box : obstacles) {
+      __m256 touchX = _mm256_and_ps(
+          _mm256_cmp_ps(maxX, _mm256_set1_ps(box.min.x), _CMP_GE_OQ),
+          _mm256_cmp_ps(minX, _mm256_set1_ps(box.max.x), _CMP_LE_OQ));
+      __m256 touchY = _mm256_and_ps(
+          _mm256_cmp_ps(maxY, _mm256_set1_ps(box.min.y), _CMP_GE_OQ),
+          _mm256_cmp_ps(minY, _mm256_set1_ps(box.max.y), _CMP_LE_OQ));
+      __m256 touch = _mm256_and_ps(touchX, touchY);
+      slowLanes = _mm256_or_ps(slowLanes, touch);
+    }
+
+    // slow balls keep their position until moveBall takes over
+    _mm256_storeu_ps(&m_x[lane], _mm256_blendv_ps(endX, x, slowLanes));
+    _mm256_storeu_ps(&m_y[lane], _mm256_blendv_ps(endY, y, slowLanes));
+    uint32_t lanes = _mm256_movemask_ps(slowLanes);
+    while (lanes) {
+      uint32_t ball = lane + std::countr_zero(lanes);
+      if (ball < last) {
+        slow.push_back(ball);
+      }
+      lanes &= lanes - 1;
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128 step = _mm_set1_ps(dt);
+  const __m128 radius = _mm_set1_ps(m_radius);
+  const __m128 lowX = _mm_set1_ps(low.x);
+  const __m128 lowY = _mm_set1_ps(low.y);
+  const __m128 highX = _mm_set1_ps(high.x);
+  const __m128 highY = _mm_set1_ps(high.y);
+
+  for (uint32_t lane = first; lane < last; lane += 4) {
+    __m128 x = _mm_loadu_ps(&m_x[lane]);
+    __m128 y = _mm_loadu_ps(&m_y[lane]);
+    __m128 velocityX = _mm_loadu_ps(&m_velocityX[lane]);
+    __m128 velocityY = _mm_loadu_ps(&m_velocityY[lane]);
+    __m128 endX = _mm_add_ps(x, _mm_mul_ps(velocityX, step));
+    __m128 endY = _mm_add_ps(y, _mm_mul_ps(velocityY, step));
+    __m128 outsideX =
+        _mm_or_ps(_mm_cmplt_ps(endX, lowX), _mm_cmpgt_ps(endX, highX));
+    __m128 outsideY =
+        _mm_or_ps(_mm_cmplt_ps(endY, lowY), _mm_cmpgt_ps(endY, highY));
+    __m128 slowLanes = _mm_or_ps(outsideX, outsideY);
+
+    __m128 minX = _mm_sub_ps(_mm_min_ps(x, endX), radius);
+    __m128 minY = _mm_sub_ps(_mm_min_ps(y, endY), radius);
+    __m128 maxX = _mm_add_ps(_mm_max_ps(x, endX), radius);
+    __m128 maxY = _mm_add_ps(_mm_max_ps(y, endY), radius);
+    for (const auto &box : obstacles) {
+      __m128 touch =
+          _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(maxX, _mm_set1_ps(box.min.x)),
+                                _mm_cmple_ps(minX, _mm_set1_ps(box.max.x))),
+                     _mm_and_ps(_mm_cmpge_ps(maxY, _mm_set1_ps(box.min.y)),
+                                _mm_cmple_ps(minY, _mm_set1_ps(box.max.y))));
+      slowLanes = _mm_or_ps(slowLanes, touch);
+    }
+
+    // SSE2 has no blend, select through the mask
+    _mm_storeu_ps(&m_x[lane], _mm_or_ps(_mm_and_ps(slowLanes, x),
+                                        _mm_andnot_ps(slowLanes, endX)));
+    _mm_storeu_ps(&m_y[lane], _mm_or_ps(_mm_and_ps(slowLanes, y),
+                                        _mm_andnot_ps(slowLanes, endY)));
+    uint32_t lanes = _mm_movemask_ps(slowLanes);
+    while (lanes) {
+      uint32_t ball = lane + std::countr_zero(lanes);
+      if (ball < last) {
+        slow.push_back(ball);
+      }
+      lanes &= lanes - 1;
+    }
+  }
+#else
+  for (uint32_t ball = first; ball < last; ball++) {
+    glm::vec2 start(m_x[ball], m_y[ball]);
+    glm::vec2 velocity(m_velocityX[ball], m_velocityY[ball]);
+    glm::vec2 end = start + velocity * dt;
+    bool isSlow = end.x < low.x || end.x > high.x || end.y < low.y ||
+                end.y > high.y;
+    glm::vec2 moveMin = glm::min(start, end) - glm::vec2(m_radius);
+    glm::vec2 moveMax = glm::max(start, end) + glm::vec2(m_radius);
+    for (const auto &box : obstacles) {
+      isSlow = isSlow || (moveMax.x >= box.min.x && moveMin.x <= box.max.x &&
+                          moveMax.y >= box.min.y && moveMin.y <= box.max.y);
+    }
+    if (isSlow) {
+      slow.push_back(ball);
+    } else {
+      m_x[ball] = end.x;
+      m_y[ball] = end.y;
+    }
+  }
+#endif
+}
@@ -0,0 +1,76 @@
+#ifndef BALLSYSTEM_H
+#define BALLSYSTEM_H
+
+#include "aabb.h"
+#include "collision.h"
+#include "jobsystem.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Any number of balls of one radius, kept as a structure of arrays padded
+// to laneWidth like BlockField. A tick first moves every ball with a SIMD
+// kernel, balls whose move would cross a wall or touch one of the obstacle
+// boxes are left in place and moved afterwards, one by one, through
+// CollisionWorld::moveBall. Far from the blocks and the pad most balls
+// never leave the kernel. Given a JobSystem, big systems are moved in
+// ranges of updateGrain balls on all threads with the same result.
+class BallSystem {
+public:
+  static constexpr uint32_t laneWidth = 8;
+  // balls one job moves, a multiple of laneWidth
+  static constexpr uint32_t updateGrain = 4096;
+
+  BallSystem();
+
+  void setup(float radius, const Aabb &field);
+  uint32_t add(glm::vec2 position, glm::vec2 velocity);
+  void clear();
+
+  uint32_t size() const { return m_count; }
+  float radius() const { return m_radius; }
+  glm::vec2 position(uint32_t ball) const {
+    return glm::vec2(m_x[ball], m_y[ball]);
+  }
+  glm::vec2 velocity(uint32_t ball) const {
+    return glm::vec2(m_velocityX[ball], m_velocityY[ball]);
+  }
+  // position before the last update(), for drawing between ticks
+  glm::vec2 previous(uint32_t ball) const {
+    return glm::vec2(m_previousX[ball], m_previousY[ball]);
+  }
+
+  // Moves every ball for dt seconds. obstacles must cover every box of
+  // world, boxes hit are appended to hits in ball order.
+  void update(const CollisionWorld &world, const std::vector<Aabb> &obstacles,
+              float dt, std::vector<uint32_t> &hits);
+  void update(const CollisionWorld &world, const std::vector<Aabb> &obstacles,
+              float dt, std::vector<uint32_t> &hits, JobSystem &jobs);
+
+private:
+  // what one job of a parallel update needs of its own
+  struct Range {
+    std::vector<uint32_t> slow;
+    std::vector<uint32_t> hits;
+    std::vector<uint32_t> candidates;
+  };
+
+  // moves the balls first to last clear of walls and obstacles, appends
+  // the others to slow
+  void advance(const std::vector<Aabb> &obstacles, float dt, uint32_t first,
+               uint32_t last, std::vector<uint32_t> &slow);
+
+  std::vector<float> m_x;
+  std::vector<float> m_y;
+  std::vector<float> m_velocityX;
+  std::vector<float> m_velocityY;
+  std::vector<float> m_previousX;
+  std::vector<float> m_previousY;
+  uint32_t m_count{0};
+  float m_radius{0};
+  Aabb m_field;
+  std::vector<uint32_t> m_slow;
+  std::vector<Range> m_ranges;
+};
+
+#endif // BALLSYSTEM_H
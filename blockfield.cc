@@ -0,0 +1,116 @@
+#include "blockfield.h"
+
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+BlockField::BlockField() {}
+
+uint32_t BlockField::add(const Aabb &box) {
+  uint32_t id = m_count++;
+  if (id % laneWidth == 0) {
+    // grow by a full lane of dead boxes
+    size_t padded = id + laneWidth;
+    m_x.resize(padded, 0.0f);
+    m_y.resize(padded, 0.0f);
+    m_halfWidth.resize(padded, 0.0f);
+    m_halfHeight.resize(padded, 0.0f);
+    m_alive.resize((padded + 63) / 64, 0);
+  }
+  set(id, box);
+  m_alive[id / 64] |= 1ull << (id % 64);
+  return id;
+}
+
+void BlockField::set(uint32_t id, const Aabb &box) {
+  m_x[id] = (box.min.x + box.max.x) * 0.5f;
+  m_y[id] = (box.min.y + box.max.y) * 0.5f;
+  m_halfWidth[id] = (box.max.x - box.min.x) * 0.5f;
+  m_halfHeight[id] = (box.max.y - box.min.y) * 0.5f;
+}
+
+void BlockField::kill(uint32_t id) { m_alive[id / 64] &= ~(1ull << (id % 64)); }
+
+Aabb BlockField::box(uint32_t id) const {
+  glm::vec2 centre(m_x[id], m_y[id]);
+  glm::vec2 half(m_halfWidth[id], m_halfHeight[id]);
+  return Aabb{centre - half, centre + half};
+}
+
+void BlockField::overlaps(const Aabb &query, std::vector<uint32_t> &ids) const {
+#if defined(__AVX2__)
+  const __m256 queryX = _mm256_set1_ps((query.min.x + query.max.x) * 0.5f);
+  const __m256 queryY = _mm256_set1_ps((query.min.y + query.max.y) * 0.5f);
+  const __m256 queryHalfWidth =
+      _mm256_set1_ps((query.max.x - query.min.x) * 0.5f);
+  const __m256 queryHalfHeight =
+      _mm256_set1_ps((query.max.y - query.min.y) * 0.5f);
+  const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+  for (uint32_t first = 0; first < m_count; first += 8) {
+    // |x - qx| <= halfWidth + qHalfWidth, same for y
+    __m256 dx = _mm256_and_ps(
+        _mm256_sub_ps(_mm256_loadu_ps(&m_x[first]), queryX), absMask);
+    __m256 dy = _mm256_and_ps(
+        _mm256_sub_ps(_mm256_loadu_ps(&m_y[first]), queryY), absMask);
+    __m256 inX = _mm256_cmp_ps(
+        dx, _mm256_add_ps(_mm256_loadu_ps(&m_halfWidth[first]), queryHalfWidth),
+        _CMP_LE_OQ);
+    __m256 inY = _mm256_cmp_ps(
+        dy,
+        _mm256_add_ps(_mm256_loadu_ps(&m_halfHeight[first]), queryHalfHeight),
+        _CMP_LE_OQ);
+    uint32_t hits = _mm256_movemask_ps(_mm256_and_ps(inX, inY));
+    hits &= (m_alive[first / 64] >> (first % 64)) & 0xff;
+    while (hits) {
+      ids.push_back(first + std::countr_zero(hits));
+      hits &= hits - 1;
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128 queryX = _mm_set1_ps((query.min.x + query.max.x) * 0.5f);
+  const __m128 queryY = _mm_set1_ps((query.min.y + query.max.y) * 0.5f);
+  const __m128 queryHalfWidth = _mm_set1_ps((query.max.x - query.min.x) * 0.5f);
+  const __m128 queryHalfHeight =
+      _mm_set1_ps((query.max.y - query.min.y) * 0.5f);
+  const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+  for (uint32_t first = 0; first < m_count; first += 4) {
+    __m128 dx =
+        _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(&m_x[first]), queryX), absMask);
+    __m128 dy =
+        _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(&m_y[first]), queryY), absMask);
+    __m128 inX = _mm_cmple_ps(
+        dx, _mm_add_ps(_mm_loadu_ps(&m_halfWidth[first]), queryHalfWidth));
+    __m128 inY = _mm_cmple_ps(
+        dy, _mm_add_ps(_mm_loadu_ps(&m_halfHeight[first]), queryHalfHeight));
+    uint32_t hits = _mm_movemask_ps(_mm_and_ps(inX, inY));
+    hits &= (m_alive[first / 64] >> (first % 64)) & 0xf;
+    while (hits) {
+      ids.push_back(first + std::countr_zero(hits));
+      hits &= hits - 1;
+    }
+  }
+#else
+  overlapsScalar(query, ids);
+#endif
+}
+
+void BlockField::overlapsScalar(const Aabb &query,
+                                std::vector<uint32_t> &ids) const {
+  float queryX = (query.min.x + query.max.x) * 0.5f;
+  float queryY = (query.min.y + query.max.y) * 0.5f;
+  float queryHalfWidth = (query.max.x - query.min.x) * 0.5f;
+  float queryHalfHeight = (query.max.y - query.min.y) * 0.5f;
+
+  for (uint32_t id = 0; id < m_count; id++) {
+    if (isAlive(id) &&
+        std::fabs(m_x[id] - queryX) <= m_halfWidth[id] + queryHalfWidth &&
+        std::fabs(m_y[id] - queryY) <= m_halfHeight[id] + queryHalfHeight) {
+      ids.push_back(id);
+    }
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef BLOCKFIELD_H
+#define BLOCKFIELD_H
+
+#include "aabb.h"
+#include <cstdint>
+#include <vector>
+
+// Boxes kept as a structure of arrays, centres and half sizes in separate
+// arrays plus an alive bitset, so a query only streams the floats it
+// compares. The arrays are padded to laneWidth entries with dead boxes so
+// the SIMD kernels never need a remainder loop. Game moves its balls
+// through a BoxGrid instead: a move touches a handful of cells holding a
+// few blocks each, and filtering those few ids with the kernel would cost
+// a gather per lane, so the field only serves worlds without a grid
+// (collisionbench times both).
+class BlockField {
+public:
+  static constexpr uint32_t laneWidth = 8;
+
+  BlockField();
+
+  uint32_t add(const Aabb &box);
+  void set(uint32_t id, const Aabb &box);
+  void kill(uint32_t id);
+  bool isAlive(uint32_t id) const {
+    return (m_alive[id / 64] >> (id % 64)) & 1;
+  }
+  Aabb box(uint32_t id) const;
+  uint32_t size() const { return m_count; }
+
+  // Appends the ids of alive boxes overlapping query. Uses AVX2 (8 boxes
+  // per compare) or SSE2 (4 boxes) when the build targets them.
+  void overlaps(const Aabb &query, std::vector<uint32_t> &ids) const;
+  // plain C++ version of the same test
+  void overlapsScalar(const Aabb &query, std::vector<uint32_t> &ids) const;
+
+private:
+  std::vector<float> m_x;
+  std::vector<float> m_y;
+  std::vector<float> m_halfWidth;
+  std::vector<float> m_halfHeight;
+  std::vector<uint64_t> m_alive;
+  uint32_t m_count{0};
+};
+
+#endif // BLOCKFIELD_H
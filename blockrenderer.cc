@@ -0,0 +1,110 @@
+#include "blockrenderer.h"
+
+#include <algorithm>
+
+BlockRenderer::BlockRenderer() {}
+
+void BlockRenderer::setup(const AssetRegistry &assets,
+                          const std::vector<GameObject> &blocks,
+                          uint32_t programId) {
+  m_programId = programId;
+  if (blocks.empty()) {
+    return;
+  }
+
+  // all blocks are copies of the same object so they share mesh and texture
+  m_meshId = blocks.front().meshId;
+  m_textureId = blocks.front().textureId;
+  const auto &dequantize = assets.mesh(m_meshId).dequantize;
+
+  m_transforms.assign(blocks.size(), Transform());
+  for (size_t n = 0; n < blocks.size(); n++) {
+    m_transforms[n].setLocal(dequantize);
+    m_transforms[n].update(blocks[n].movement, blocks[n].rotation,
+                           blocks[n].scale);
+  }
+  m_dirty.clear();
+  for (auto &region : m_regions) {
+    region = Region();
+  }
+}
+
+void BlockRenderer::update(const std::vector<GameObject> &blocks,
+                           const std::vector<uint32_t> &indices,
+                           JobSystem &jobs) {
+  m_changed.assign(indices.size(), 0);
+  Job *root = jobs.create(nullptr);
+  jobs.runRanges(indices.size(), updateGrain, root,
+                 [&](size_t first, size_t last) {
+                   for (size_t n = first; n < last; n++) {
+                     uint32_t index = indices[n];
+                     const auto &block = blocks[index];
+                     m_changed[n] =
+                         index < m_transforms.size() &&
+                         m_transforms[index].update(
+                             block.movement, block.rotation, block.scale);
+                   }
+                 });
+  jobs.run(root);
+  jobs.wait(root);
+
+  // the dirty list is appended in index order, whatever job finished first
+  for (size_t n = 0; n < indices.size(); n++) {
+    if (m_changed[n]) {
+      m_dirty.emplace_back(indices[n], m_frame);
+    }
+  }
+}
+
+void BlockRenderer::submit(RenderQueue &queue, JobSystem &jobs, Job *parent) {
+  if (m_transforms.empty()) {
+    return;
+  }
+  uint32_t baseInstance;
+  glm::mat4 *instances =
+      queue.allocateInstances(m_transforms.size(), baseInstance);
+  if (instances == nullptr) {
+    return;
+  }
+
+  auto &region = m_regions[queue.instanceRegion()];
+  if (region.baseInstance != baseInstance) {
+    // first use of this region or the blocks moved inside it
+    jobs.runRanges(m_transforms.size(), fillGrain, parent,
+                   [this, instances](size_t first, size_t last) {
+                     for (size_t n = first; n < last; n++) {
+                       instances[n] = m_transforms[n].matrix();
+                     }
+                   });
+  } else {
+    for (const auto &[index, frame] : m_dirty) {
+      if (frame >= region.frame) {
+        instances[index] = m_transforms[index].matrix();
+      }
+    }
+  }
+  region.baseInstance = baseInstance;
+  region.frame = ++m_frame;
+
+  // changes every region has seen are done
+  uint64_t oldest = m_frame;
+  for (const auto &written : m_regions) {
+    oldest = std::min(oldest, written.frame);
+  }
+  m_dirty.erase(std::remove_if(m_dirty.begin(), m_dirty.end(),
+                               [oldest](const auto &dirty) {
+                                 return dirty.second < oldest;
+                               }),
+                m_dirty.end());
+
+  // the grid is flat, the first block stands in for the depth of all
+  glm::vec3 position(m_transforms[0].matrix()[3]);
+  queue.submitInstanced(m_programId, m_textureId, m_meshId,
+                        m_transforms.size(), baseInstance,
+                        queue.depth(position));
+}
+
+void BlockRenderer::release() {
+  m_transforms.clear();
+  m_dirty.clear();
+}
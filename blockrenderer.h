@@ -0,0 +1,58 @@
+#ifndef BLOCKRENDERER_H
+#define BLOCKRENDERER_H
+
+#include "assetregistry.h"
+#include "gameobject.h"
+#include "jobsystem.h"
+#include "renderqueue.h"
+#include "transform.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Submits every block of the grid as one instanced draw packet.
+// Block transforms are cached and only rebuilt for blocks passed to
+// update() with a changed movement, rotation or scale. Each instance ring
+// region keeps the block matrices written to it, so a frame only writes the
+// blocks that changed since that region was last filled.
+class BlockRenderer {
+public:
+  // matrices one job copies when a region is filled from scratch
+  static constexpr size_t fillGrain = 4096;
+  // transforms one job rebuilds in update()
+  static constexpr size_t updateGrain = 1024;
+
+  BlockRenderer();
+
+  void setup(const AssetRegistry &assets, const std::vector<GameObject> &blocks,
+             uint32_t programId);
+  // rebuilds the transforms of the blocks listed in indices in ranges on
+  // jobs, blocks that changed are marked dirty in index order
+  void update(const std::vector<GameObject> &blocks,
+              const std::vector<uint32_t> &indices, JobSystem &jobs);
+  // Dirty blocks are copied right away, a region filled from scratch is
+  // copied by child jobs of parent. Its matrices are complete once parent
+  // has finished.
+  void submit(RenderQueue &queue, JobSystem &jobs, Job *parent);
+  void release();
+
+private:
+  struct Region {
+    uint32_t baseInstance{0xffffffff};
+    uint64_t frame{0}; // m_frame when the region was last written
+  };
+
+  std::vector<Transform> m_transforms;
+  // blocks whose matrix changed and the frame it changed in
+  std::vector<std::pair<uint32_t, uint64_t>> m_dirty;
+  std::vector<uint8_t> m_changed; // per index of a ranged update
+  Region m_regions[InstanceRing::regionCount];
+  uint64_t m_frame{0};
+
+  uint32_t m_programId{0};
+  uint32_t m_textureId{0};
+  uint32_t m_meshId{0};
+};
+
+#endif // BLOCKRENDERER_H
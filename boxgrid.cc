@@ -0,0 +1,154 @@
+#include "boxgrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+BoxGrid::BoxGrid() {}
+
+void BoxGrid::build(const std::vector<Aabb> &boxes,
+                    const std::vector<uint32_t> &ids, glm::vec2 cellSize) {
+  m_cells.clear();
+  m_stamps.assign(boxes.size(), 0);
+  m_query = 0;
+  if (ids.empty()) {
+    m_columns = m_rows = 0;
+    return;
+  }
+
+  Aabb bounds = boxes[ids[0]];
+  for (auto id : ids) {
+    bounds.min = glm::min(bounds.min, boxes[id].min);
+    bounds.max = glm::max(bounds.max, boxes[id].max);
+  }
+  m_origin = bounds.min;
+  m_cellSize = cellSize;
+  m_columns = std::max<int32_t>(
+      1, (int32_t)std::ceil((bounds.max.x - bounds.min.x) / cellSize.x));
+  m_rows = std::max<int32_t>(
+      1, (int32_t)std::ceil((bounds.max.y - bounds.min.y) / cellSize.y));
+  m_cells.resize((size_t)m_columns * m_rows);
+
+  for (auto id : ids) {
+    insert(id, boxes[id]);
+  }
+}
+
+void BoxGrid::insert(uint32_t id, const Aabb &box) {
+  if (id >= m_stamps.size()) {
+    m_stamps.resize(id + 1, 0);
+  }
+  for (int32_t y = row(box.min.y); y <= row(box.max.y); y++) {
+    for (int32_t x = column(box.min.x); x <= column(box.max.x); x++) {
+      m_cells[(size_t)y * m_columns + x].push_back(id);
+    }
+  }
+}
+
+void BoxGrid::remove(uint32_t id, const Aabb &box) {
+  for (int32_t y = row(box.min.y); y <= row(box.max.y); y++) {
+    for (int32_t x = column(box.min.x); x <= column(box.max.x); x++) {
+      auto &cell = m_cells[(size_t)y * m_columns + x];
+      auto found = std::find(cell.begin(), cell.end(), id);
+      if (found != cell.end()) {
+        *found = cell.back();
+        cell.pop_back();
+      }
+    }
+  }
+}
+
+// Walks the rows the swept circle covers and, per row, only the columns the
+// path crosses while inside that row, so a diagonal move visits a band of
+// cells instead of its whole bounding box.
+void BoxGrid::query(glm::vec2 start, glm::vec2 delta, float radius,
+                    std::vector<uint32_t> &ids) const {
+  if (m_cells.empty()) {
+    return;
+  }
+  if (++m_query == 0) { // stamps wrapped, start over
+    std::fill(m_stamps.begin(), m_stamps.end(), 0);
+    m_query = 1;
+  }
+  walk(start, delta, radius, true, ids);
+}
+
+void BoxGrid::queryShared(glm::vec2 start, glm::vec2 delta, float radius,
+                          std::vector<uint32_t> &ids) const {
+  if (m_cells.empty()) {
+    return;
+  }
+  size_t first = ids.size();
+  walk(start, delta, radius, false, ids);
+
+  // a move touches a handful of boxes, a linear search beats any set
+  size_t kept = first;
+  for (size_t n = first; n < ids.size(); n++) {
+    if (std::find(ids.begin() + first, ids.begin() + kept, ids[n]) ==
+        ids.begin() + kept) {
+      ids[kept++] = ids[n];
+    }
+  }
+  ids.resize(kept);
+}
+
+void BoxGrid::walk(glm::vec2 start, glm::vec2 delta, float radius, bool stamp,
+                   std::vector<uint32_t> &ids) const {
+  glm::vec2 end = start + delta;
+  int32_t firstRow = row(std::min(start.y, end.y) - radius);
+  int32_t lastRow = row(std::max(start.y, end.y) + radius);
+
+  for (int32_t y = firstRow; y <= lastRow; y++) {
+    float t0{0.0f}, t1{1.0f};
+    if (delta.y != 0.0f) {
+      // part of the move where the circle overlaps this row
+      float bandLow = m_origin.y + y * m_cellSize.y - radius;
+      float bandHigh = bandLow + m_cellSize.y + 2.0f * radius;
+      // border cells also hold what lies outside of the grid
+      if (y == 0) {
+        bandLow = -std::numeric_limits<float>::infinity();
+      }
+      if (y == m_rows - 1) {
+        bandHigh = std::numeric_limits<float>::infinity();
+      }
+      t0 = (bandLow - start.y) / delta.y;
+      t1 = (bandHigh - start.y) / delta.y;
+      if (t0 > t1) {
+        std::swap(t0, t1);
+      }
+      t0 = std::max(t0, 0.0f);
+      t1 = std::min(t1, 1.0f);
+      if (t0 > t1) {
+        continue;
+      }
+    }
+    float x0 = start.x + delta.x * t0;
+    float x1 = start.x + delta.x * t1;
+    addIds(y, column(std::min(x0, x1) - radius),
+           column(std::max(x0, x1) + radius), stamp, ids);
+  }
+}
+
+int32_t BoxGrid::column(float x) const {
+  float cell = std::floor((x - m_origin.x) / m_cellSize.x);
+  return (int32_t)std::clamp(cell, 0.0f, (float)(m_columns - 1));
+}
+
+int32_t BoxGrid::row(float y) const {
+  float cell = std::floor((y - m_origin.y) / m_cellSize.y);
+  return (int32_t)std::clamp(cell, 0.0f, (float)(m_rows - 1));
+}
+
+void BoxGrid::addIds(int32_t row, int32_t firstColumn, int32_t lastColumn,
+                     bool stamp, std::vector<uint32_t> &ids) const {
+  for (int32_t x = firstColumn; x <= lastColumn; x++) {
+    for (auto id : m_cells[(size_t)row * m_columns + x]) {
+      if (!stamp) {
+        ids.push_back(id);
+      } else if (m_stamps[id] != m_query) {
+        m_stamps[id] = m_query;
+        ids.push_back(id);
+      }
+    }
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef BOXGRID_H
+#define BOXGRID_H
+
+#include "aabb.h"
+#include <cstdint>
+#include <vector>
+
+// Uniform grid over the play field, every cell lists the ids of the boxes
+// overlapping it. Sized from the boxes it is built from, so a grid of
+// blocks gets one cell per block row and column. Boxes outside of the grid
+// are kept in the border cells.
+class BoxGrid {
+public:
+  BoxGrid();
+
+  // cells of cellSize covering every box in ids
+  void build(const std::vector<Aabb> &boxes, const std::vector<uint32_t> &ids,
+             glm::vec2 cellSize);
+  void insert(uint32_t id, const Aabb &box);
+  void remove(uint32_t id, const Aabb &box);
+  bool isEmpty() const { return m_cells.empty(); }
+
+  // Appends, once each, the ids listed in the cells touched by a circle of
+  // radius moving from start by delta. Not thread safe, uses a query stamp.
+  void query(glm::vec2 start, glm::vec2 delta, float radius,
+             std::vector<uint32_t> &ids) const;
+  // Same ids in the same order as query() without touching the query
+  // stamp, so any number of threads can query one grid at once.
+  void queryShared(glm::vec2 start, glm::vec2 delta, float radius,
+                   std::vector<uint32_t> &ids) const;
+
+private:
+  int32_t column(float x) const;
+  int32_t row(float y) const;
+  // appends the ids of the cells the move crosses, deduplicated through
+  // the query stamp when stamp is set
+  void walk(glm::vec2 start, glm::vec2 delta, float radius, bool stamp,
+            std::vector<uint32_t> &ids) const;
+  void addIds(int32_t row, int32_t firstColumn, int32_t lastColumn, bool stamp,
+              std::vector<uint32_t> &ids) const;
+
+  glm::vec2 m_origin{0.0f};
+  glm::vec2 m_cellSize{1.0f};
+  int32_t m_columns{0};
+  int32_t m_rows{0};
+  std::vector<std::vector<uint32_t>> m_cells;
+  // last query each id was returned by
+  mutable std::vector<uint32_t> m_stamps;
+  mutable uint32_t m_query{0};
+};
+
+#endif // BOXGRID_H
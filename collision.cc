@@ -0,0 +1,227 @@
+#include "collision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+// the box is grown by radius, the circle is then a ray, except in the
+// corners where the grown shape is rounded
+bool sweepCorner(glm::vec2 start, glm::vec2 delta, float radius,
+                 glm::vec2 corner, SweepHit &hit) {
+  glm::vec2 m = start - corner;
+  float a = glm::dot(delta, delta);
+  float b = glm::dot(m, delta);
+  float c = glm::dot(m, m) - radius * radius;
+  if (b >= 0.0f) {
+    return false; // moving away from the corner
+  }
+  float discriminant = b * b - a * c;
+  if (discriminant < 0.0f || a == 0.0f) {
+    return false;
+  }
+  float time = std::max((-b - std::sqrt(discriminant)) / a, 0.0f);
+  if (time > 1.0f) {
+    return false;
+  }
+  hit.time = time;
+  hit.normal = glm::normalize(start + delta * time - corner);
+  return true;
+}
+} // namespace
+
+bool sweepCircle(glm::vec2 start, glm::vec2 delta, float radius,
+                 const Aabb &box, SweepHit &hit) {
+  glm::vec2 low = box.min - glm::vec2(radius);
+  glm::vec2 high = box.max + glm::vec2(radius);
+
+  float enter = -std::numeric_limits<float>::infinity();
+  float exit = std::numeric_limits<float>::infinity();
+  int enterAxis = -1;
+  for (int axis = 0; axis < 2; axis++) {
+    if (delta[axis] == 0.0f) {
+      if (start[axis] < low[axis] || start[axis] > high[axis]) {
+        return false;
+      }
+      continue;
+    }
+    float inverse = 1.0f / delta[axis];
+    float near = (low[axis] - start[axis]) * inverse;
+    float far = (high[axis] - start[axis]) * inverse;
+    if (near > far) {
+      std::swap(near, far);
+    }
+    if (near > enter) {
+      enter = near;
+      enterAxis = axis;
+    }
+    exit = std::min(exit, far);
+    if (enter > exit) {
+      return false;
+    }
+  }
+  if (exit < 0.0f || enter > 1.0f || enterAxis < 0) {
+    return false;
+  }
+
+  bool startOutsideX = start.x < box.min.x || start.x > box.max.x;
+  bool startOutsideY = start.y < box.min.y || start.y > box.max.y;
+  if (enter < 0.0f && startOutsideX && startOutsideY) {
+    // inside the grown box but only in a corner, which is rounded
+    glm::vec2 corner(start.x < box.min.x ? box.min.x : box.max.x,
+                     start.y < box.min.y ? box.min.y : box.max.y);
+    return sweepCorner(start, delta, radius, corner, hit);
+  }
+  if (enter < 0.0f) {
+    // already overlapping, push out through the closest face
+    float depths[4] = {start.x - low.x, high.x - start.x, start.y - low.y,
+                       high.y - start.y};
+    const glm::vec2 normals[4] = {glm::vec2(-1.0f, 0.0f), glm::vec2(1.0f, 0.0f),
+                                  glm::vec2(0.0f, -1.0f), glm::vec2(0.0f, 1.0f)};
+    int face = std::min_element(depths, depths + 4) - depths;
+    if (glm::dot(delta, normals[face]) >= 0.0f) {
+      return false; // already leaving
+    }
+    hit.time = 0.0f;
+    hit.normal = normals[face];
+    return true;
+  }
+
+  glm::vec2 point = start + delta * enter;
+  bool outsideX = point.x < box.min.x || point.x > box.max.x;
+  bool outsideY = point.y < box.min.y || point.y > box.max.y;
+  if (outsideX && outsideY) {
+    glm::vec2 corner(point.x < box.min.x ? box.min.x : box.max.x,
+                     point.y < box.min.y ? box.min.y : box.max.y);
+    return sweepCorner(start, delta, radius, corner, hit);
+  }
+
+  hit.time = enter;
+  hit.normal = glm::vec2(0.0f);
+  hit.normal[enterAxis] = delta[enterAxis] > 0.0f ? -1.0f : 1.0f;
+  return true;
+}
+
+// the ball is kept inside the field, each wall is a half plane
+bool sweepWalls(glm::vec2 start, glm::vec2 delta, float radius,
+                const Aabb &field, SweepHit &hit) {
+  glm::vec2 low = field.min + glm::vec2(radius);
+  glm::vec2 high = field.max - glm::vec2(radius);
+  bool found{false};
+
+  for (int axis = 0; axis < 2; axis++) {
+    float time{0.0f};
+    float normal{0.0f};
+    if (delta[axis] > 0.0f && start[axis] + delta[axis] > high[axis]) {
+      time = (high[axis] - start[axis]) / delta[axis];
+      normal = -1.0f;
+    } else if (delta[axis] < 0.0f && start[axis] + delta[axis] < low[axis]) {
+      time = (low[axis] - start[axis]) / delta[axis];
+      normal = 1.0f;
+    } else {
+      continue;
+    }
+    time = std::max(time, 0.0f);
+    if (!found || time < hit.time) {
+      hit.time = time;
+      hit.normal = glm::vec2(0.0f);
+      hit.normal[axis] = normal;
+      found = true;
+    }
+  }
+  return found;
+}
+
+CollisionWorld::CollisionWorld() {}
+
+void CollisionWorld::setField(const Aabb &field) { m_field = field; }
+
+uint32_t CollisionWorld::addBox(const Aabb &box, bool dynamic) {
+  uint32_t boxId = m_boxes.add(box);
+  m_bounds.push_back(box);
+  m_dynamic.push_back(dynamic);
+  if (dynamic) {
+    m_dynamicIds.push_back(boxId);
+  } else if (!m_grid.isEmpty()) {
+    m_grid.insert(boxId, m_bounds[boxId]);
+  }
+  return boxId;
+}
+
+void CollisionWorld::buildBroadphase() {
+  std::vector<uint32_t> staticIds;
+  glm::vec2 cellSize{0.0f};
+  for (uint32_t boxId = 0; boxId < m_boxes.size(); boxId++) {
+    if (m_boxes.isAlive(boxId) && !m_dynamic[boxId]) {
+      staticIds.push_back(boxId);
+      cellSize = glm::max(cellSize, m_bounds[boxId].max - m_bounds[boxId].min);
+    }
+  }
+  // boxes then overlap at most four cells
+  m_grid.build(m_bounds, staticIds, glm::max(cellSize, glm::vec2(1.0f)));
+}
+
+void CollisionWorld::moveBox(uint32_t boxId, const Aabb &box) {
+  bool gridded = !m_dynamic[boxId] && !m_grid.isEmpty();
+  if (gridded && m_boxes.isAlive(boxId)) {
+    m_grid.remove(boxId, m_bounds[boxId]);
+  }
+  m_boxes.set(boxId, box);
+  m_bounds[boxId] = box;
+  if (gridded && m_boxes.isAlive(boxId)) {
+    m_grid.insert(boxId, m_bounds[boxId]);
+  }
+}
+
+void CollisionWorld::removeBox(uint32_t boxId) {
+  if (!m_dynamic[boxId] && !m_grid.isEmpty() && m_boxes.isAlive(boxId)) {
+    m_grid.remove(boxId, m_bounds[boxId]);
+  }
+  m_boxes.kill(boxId);
+}
+
+void CollisionWorld::moveBall(glm::vec2 &position, glm::vec2 &velocity,
+                              float radius, float dt,
+                              std::vector<uint32_t> &hits) const {
+  moveBall(position, velocity, radius, dt, hits, m_candidates, false);
+}
+
+void CollisionWorld::moveBallShared(glm::vec2 &position, glm::vec2 &velocity,
+                                    float radius, float dt,
+                                    std::vector<uint32_t> &hits,
+                                    std::vector<uint32_t> &candidates) const {
+  moveBall(position, velocity, radius, dt, hits, candidates, true);
+}
+
+// shared queries skip the grid's query stamp, which only one thread may use
+void CollisionWorld::moveBall(glm::vec2 &position, glm::vec2 &velocity,
+                              float radius, float dt,
+                              std::vector<uint32_t> &hits,
+                              std::vector<uint32_t> &candidates,
+                              bool shared) const {
+  moveBallThrough(
+      position, velocity, radius, dt, m_field, hits, candidates,
+      [this, radius, shared](glm::vec2 start, glm::vec2 delta,
+                             std::vector<uint32_t> &ids) {
+        if (m_grid.isEmpty()) {
+          glm::vec2 end = start + delta;
+          Aabb bounds{glm::min(start, end) - glm::vec2(radius),
+                      glm::max(start, end) + glm::vec2(radius)};
+          m_boxes.overlaps(bounds, ids);
+          return;
+        }
+        ids = m_dynamicIds;
+        if (shared) {
+          m_grid.queryShared(start, delta, radius, ids);
+        } else {
+          m_grid.query(start, delta, radius, ids);
+        }
+      },
+      [this](uint32_t boxId, Aabb &bounds) {
+        if (!m_boxes.isAlive(boxId)) {
+          return false;
+        }
+        bounds = m_bounds[boxId];
+        return true;
+      });
+}
@@ -0,0 +1,126 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include "aabb.h"
+#include "blockfield.h"
+#include "boxgrid.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct SweepHit {
+  float time{1.0f};       // fraction of the move done before contact
+  glm::vec2 normal{0.0f}; // contact normal, pointing away from the box
+};
+
+// Circle of radius moving from start by delta against a box. Fills hit and
+// returns true when it touches the box during the move. A circle already
+// overlapping the box and moving further in hits at time 0.
+bool sweepCircle(glm::vec2 start, glm::vec2 delta, float radius,
+                 const Aabb &box, SweepHit &hit);
+// Circle of radius moving from start by delta inside field, every edge of
+// it a wall. Fills hit with the first wall reached and returns true.
+bool sweepWalls(glm::vec2 start, glm::vec2 delta, float radius,
+                const Aabb &field, SweepHit &hit);
+
+// Static and moving boxes the ball bounces off, inside a walled field.
+// The ball is moved with continuous collision, so it cannot tunnel through
+// a box no matter how far it travels in one step. Boxes live in a
+// BlockField, without a broadphase the candidates of a move are the boxes
+// overlapping its bounds, found by the SIMD kernel. Once buildBroadphase()
+// is called static boxes are found through a BoxGrid and dynamic boxes are
+// always tested. Game always builds the broadphase, the SIMD kernel only
+// serves worlds without one.
+class CollisionWorld {
+public:
+  static constexpr uint32_t noBox = 0xffffffff;
+  // bounces resolved in one step, the rest of a step is dropped after that
+  static constexpr uint32_t maxContacts = 8;
+  // distance kept from a surface after a bounce so the next sweep starts
+  // outside of it
+  static constexpr float skin = 0.01f;
+
+  CollisionWorld();
+
+  void setField(const Aabb &field);
+  // dynamic boxes are expected to move every frame, like the pad
+  uint32_t addBox(const Aabb &box, bool dynamic = false);
+  // grids the static boxes added so far, cells sized to fit the largest
+  void buildBroadphase();
+  void moveBox(uint32_t boxId, const Aabb &box);
+  void removeBox(uint32_t boxId);
+  bool isAlive(uint32_t boxId) const { return m_boxes.isAlive(boxId); }
+
+  // Moves the ball for dt seconds, reflecting the velocity at every wall
+  // and box it touches. Boxes hit are appended to hits in contact order.
+  void moveBall(glm::vec2 &position, glm::vec2 &velocity, float radius,
+                float dt, std::vector<uint32_t> &hits) const;
+  // Same as moveBall() with a caller owned candidate buffer, so several
+  // threads may move balls at once while the boxes stay put.
+  void moveBallShared(glm::vec2 &position, glm::vec2 &velocity, float radius,
+                      float dt, std::vector<uint32_t> &hits,
+                      std::vector<uint32_t> &candidates) const;
+
+private:
+  void moveBall(glm::vec2 &position, glm::vec2 &velocity, float radius,
+                float dt, std::vector<uint32_t> &hits,
+                std::vector<uint32_t> &candidates, bool shared) const;
+
+  Aabb m_field;
+  BlockField m_boxes;
+  // the boxes as given, sweeps and the grid use these since BlockField
+  // keeps centres and half sizes, which do not give the corners back
+  // exactly, and GameBatch sweeps the corners as given
+  std::vector<Aabb> m_bounds;
+  std::vector<uint8_t> m_dynamic;
+  std::vector<uint32_t> m_dynamicIds;
+  BoxGrid m_grid;
+  mutable std::vector<uint32_t> m_candidates;
+};
+
+// The ball move of CollisionWorld::moveBall over any store of boxes, so
+// GameBatch, whose games share one grid of blocks, moves its balls exactly
+// like Game. query(start, delta, candidates) fills the ids of the boxes a
+// move may touch, box(id, bounds) fills the bounds of one of them and
+// returns false when it is gone. Boxes hit are appended to hits.
+template <typename Query, typename Box>
+void moveBallThrough(glm::vec2 &position, glm::vec2 &velocity, float radius,
+                     float dt, const Aabb &field, std::vector<uint32_t> &hits,
+                     std::vector<uint32_t> &candidates, Query query, Box box) {
+  float remaining = dt;
+  for (uint32_t contacts = 0;
+       contacts < CollisionWorld::maxContacts && remaining > 0.0f;
+       contacts++) {
+    glm::vec2 delta = velocity * remaining;
+    // earliest wall or box touched during the move
+    SweepHit first;
+    uint32_t firstBox = CollisionWorld::noBox;
+    bool found = sweepWalls(position, delta, radius, field, first);
+    candidates.clear();
+    query(position, delta, candidates);
+    for (auto boxId : candidates) {
+      Aabb bounds;
+      SweepHit hit;
+      if (box(boxId, bounds) &&
+          sweepCircle(position, delta, radius, bounds, hit) &&
+          (!found || hit.time < first.time)) {
+        first = hit;
+        firstBox = boxId;
+        found = true;
+      }
+    }
+
+    if (!found) {
+      position += delta;
+      return;
+    }
+    position += delta * first.time + first.normal * CollisionWorld::skin;
+    velocity = glm::reflect(velocity, first.normal);
+    remaining *= 1.0f - first.time;
+    if (firstBox != CollisionWorld::noBox) {
+      hits.push_back(firstBox);
+    }
+  }
+}
+
+#endif // COLLISION_H
@@ -0,0 +1,178 @@
+// Times box overlap queries over a large field of blocks: the old scan over
+// GameObjects computing each block's bounds, BlockField::overlapsScalar, the
+// SIMD BlockField::overlaps and a BoxGrid lookup followed by the exact box
+// test, which is how the game finds blocks. Exits with 1 when the SIMD
+// kernel disagrees with the scalar version or with the grid on any query.
+//   collisionbench [blocks] [queries]
+
+#include "blockfield.h"
+#include "boxgrid.h"
+#include "gameobject.h"
+#include "random.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+// bounds of block.obj around its origin, scaled like the game's blocks
+const glm::vec2 blockMin(-1.0f, -0.5f);
+const glm::vec2 blockMax(1.0f, 0.5f);
+constexpr uint32_t blocksPerRow = 400;
+
+struct Timing {
+  double microseconds{0};
+  size_t found{0};
+};
+
+template <typename Query>
+Timing run(const std::vector<Aabb> &queries, Query query,
+           std::vector<std::vector<uint32_t>> &results) {
+  results.assign(queries.size(), {});
+  auto start = std::chrono::steady_clock::now();
+  for (size_t n = 0; n < queries.size(); n++) {
+    query(queries[n], results[n]);
+  }
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  Timing timing;
+  timing.microseconds = elapsed.count() / queries.size();
+  for (const auto &ids : results) {
+    timing.found += ids.size();
+  }
+  return timing;
+}
+
+void print(const std::string &name, const Timing &timing) {
+  std::cout << "  " << name << " " << timing.microseconds << " us/query, "
+            << timing.found << " boxes found" << std::endl;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  uint32_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  uint32_t queryCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+
+  std::vector<GameObject> blocks(count);
+  std::vector<uint8_t> alive(count, 1);
+  std::vector<Aabb> bounds;
+  BlockField field;
+  for (uint32_t n = 0; n < count; n++) {
+    auto &block = blocks[n];
+    block.movement = glm::vec3((n % blocksPerRow) * 20.0f,
+                               (n / blocksPerRow) * 8.0f, 200.0f);
+    glm::vec2 position(block.movement.x, block.movement.y);
+    glm::vec2 scale(block.scale.x, block.scale.y);
+    bounds.push_back(
+        Aabb{position + blockMin * scale, position + blockMax * scale});
+    field.add(bounds.back());
+  }
+  // some blocks already destroyed, like a game in progress
+  for (uint32_t n = 0; n < count; n += 7) {
+    alive[n] = 0;
+    field.kill(n);
+  }
+  std::vector<uint32_t> aliveIds;
+  for (uint32_t n = 0; n < count; n++) {
+    if (alive[n]) {
+      aliveIds.push_back(n);
+    }
+  }
+  // one cell per block, like CollisionWorld::buildBroadphase()
+  BoxGrid grid;
+  grid.build(bounds, aliveIds, bounds[0].max - bounds[0].min);
+
+  Random random(5);
+  float width = blocksPerRow * 20.0f;
+  float height = (count / blocksPerRow + 1) * 8.0f;
+  std::vector<Aabb> queries(queryCount);
+  for (auto &query : queries) {
+    glm::vec2 centre(random.uniform(0.0f, width),
+                     random.uniform(0.0f, height));
+    query = Aabb{centre - glm::vec2(30.0f), centre + glm::vec2(30.0f)};
+  }
+
+  std::vector<std::vector<uint32_t>> objects, scalar, simd, gridded;
+  auto objectTiming = run(
+      queries,
+      [&](const Aabb &query, std::vector<uint32_t> &ids) {
+        for (uint32_t n = 0; n < count; n++) {
+          if (!alive[n]) {
+            continue;
+          }
+          const auto &block = blocks[n];
+          glm::vec2 position(block.movement.x, block.movement.y);
+          glm::vec2 scale(block.scale.x, block.scale.y);
+          glm::vec2 low = position + blockMin * scale;
+          glm::vec2 high = position + blockMax * scale;
+          if (low.x <= query.max.x && high.x >= query.min.x &&
+              low.y <= query.max.y && high.y >= query.min.y) {
+            ids.push_back(n);
+          }
+        }
+      },
+      objects);
+  auto scalarTiming = run(
+      queries,
+      [&](const Aabb &query, std::vector<uint32_t> &ids) {
+        field.overlapsScalar(query, ids);
+      },
+      scalar);
+  auto simdTiming = run(
+      queries,
+      [&](const Aabb &query, std::vector<uint32_t> &ids) {
+        field.overlaps(query, ids);
+      },
+      simd);
+  std::vector<uint32_t> candidates;
+  auto gridTiming = run(
+      queries,
+      [&](const Aabb &query, std::vector<uint32_t> &ids) {
+        glm::vec2 centre = (query.min + query.max) * 0.5f;
+        candidates.clear();
+        grid.query(centre, glm::vec2(0.0f), (query.max.x - query.min.x) * 0.5f,
+                   candidates);
+        for (auto id : candidates) {
+          const auto &box = bounds[id];
+          if (box.min.x <= query.max.x && box.max.x >= query.min.x &&
+              box.min.y <= query.max.y && box.max.y >= query.min.y) {
+            ids.push_back(id);
+          }
+        }
+        std::sort(ids.begin(), ids.end());
+      },
+      gridded);
+
+#if defined(__AVX2__)
+  const std::string kernel = "AVX2";
+#elif defined(__SSE2__)
+  const std::string kernel = "SSE2";
+#else
+  const std::string kernel = "scalar";
+#endif
+  std::cout << count << " blocks, " << queryCount << " queries" << std::endl;
+  print("GameObject scan    ", objectTiming);
+  print("SoA scalar         ", scalarTiming);
+  print("SoA " + kernel + std::string(15 - kernel.size(), ' '), simdTiming);
+  print("BoxGrid            ", gridTiming);
+
+  for (size_t n = 0; n < queries.size(); n++) {
+    if (simd[n] != scalar[n]) {
+      std::cerr << "Error query " << n << " found " << simd[n].size()
+                << " boxes with the SIMD kernel and " << scalar[n].size()
+                << " with the scalar one" << std::endl;
+      return 1;
+    }
+    if (simd[n] != gridded[n]) {
+      std::cerr << "Error query " << n << " found " << simd[n].size()
+                << " boxes with the SIMD kernel and " << gridded[n].size()
+                << " through the grid" << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
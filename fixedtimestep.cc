@@ -0,0 +1,18 @@
+#include "fixedtimestep.h"
+
+#include <algorithm>
+
+FixedTimestep::FixedTimestep(double tickRate, uint32_t maxTicks)
+    : m_dt(1.0 / tickRate), m_maxTicks(maxTicks) {}
+
+uint32_t FixedTimestep::advance(double frameTime) {
+  m_accumulator += std::max(frameTime, 0.0);
+
+  uint32_t ticks = (uint32_t)std::min(m_accumulator / m_dt, (double)m_maxTicks);
+  m_accumulator -= ticks * m_dt;
+  if (ticks == m_maxTicks) {
+    // behind by more than maxTicks, drop the rest instead of catching up
+    m_accumulator = std::min(m_accumulator, m_dt * 0.999);
+  }
+  return ticks;
+}
@@ -0,0 +1,28 @@
+#ifndef FIXEDTIMESTEP_H
+#define FIXEDTIMESTEP_H
+
+#include <cstdint>
+
+// Turns variable frame times into a whole number of fixed simulation ticks.
+// The time left over is kept for the next frame and exposed as alpha() so
+// the renderer can blend between the last two simulated states. A frame
+// never runs more than maxTicks ticks, time beyond that is dropped so one
+// slow frame cannot snowball into ever slower ones.
+class FixedTimestep {
+public:
+  explicit FixedTimestep(double tickRate = 120.0, uint32_t maxTicks = 8);
+
+  float dt() const { return (float)m_dt; }
+
+  // adds the frame time and returns the ticks to simulate now
+  uint32_t advance(double frameTime);
+  // fraction of a tick waiting in the accumulator, 0 to 1
+  float alpha() const { return (float)(m_accumulator / m_dt); }
+
+private:
+  double m_dt;
+  double m_accumulator{0.0};
+  uint32_t m_maxTicks;
+};
+
+#endif // FIXEDTIMESTEP_H
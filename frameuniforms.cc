@@ -0,0 +1,35 @@
+#include "glad.h"
+
+#include "frameuniforms.h"
+
+static_assert(sizeof(FrameData) == 2 * 64 + 16 + 16,
+              "FrameData must match the std140 layout of the Frame block");
+
+FrameUniforms::FrameUniforms() {}
+
+void FrameUniforms::setup() {
+  glGenBuffers(1, &m_UBO);
+  glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, m_UBO);
+}
+
+void FrameUniforms::update(const glm::mat4 &view, const glm::mat4 &projection,
+                           const glm::vec4 &viewport, float time) {
+  FrameData data;
+  data.view = view;
+  data.projection = projection;
+  data.viewport = viewport;
+  data.time = time;
+
+  glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameUniforms::release() {
+  glDeleteBuffers(1, &m_UBO);
+  m_UBO = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef FRAMEUNIFORMS_H
+#define FRAMEUNIFORMS_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Matches the std140 "Frame" uniform block declared in the shaders.
+struct FrameData {
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::vec4 viewport; // x, y, width, height
+  float time;
+  float padding[3];
+};
+
+// Uniform buffer with the per frame camera state, uploaded once a frame and
+// bound to one binding point that every program reads from.
+class FrameUniforms {
+public:
+  static constexpr uint32_t bindingPoint = 0;
+
+  FrameUniforms();
+
+  void setup();
+  void update(const glm::mat4 &view, const glm::mat4 &projection,
+              const glm::vec4 &viewport, float time);
+  void release();
+
+private:
+  uint32_t m_UBO{0};
+};
+
+#endif // FRAMEUNIFORMS_H
@@ -0,0 +1,151 @@
+#include "game.h"
+#include "meshcache.h"
+#include "wavefrontreader.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool readShape(const std::string &filename, Shape &shape) {
+  auto cacheFilename = meshCacheName(filename);
+  if (meshCacheIsFresh(filename, cacheFilename)) {
+    MeshCacheFile cache(cacheFilename);
+    if (cache.isValid()) {
+      const auto &header = cache.header();
+      shape.boundsMin = header.boundsMin;
+      shape.boundsMax = header.boundsMax;
+      shape.width = header.width;
+      shape.height = header.height;
+      return true;
+    }
+  }
+
+  Mesh mesh;
+  WaveFrontReader reader(filename);
+  // a file cut off inside a face leaves a partial triangle behind
+  if (!reader.readVertices(mesh) || mesh.indicies.empty() ||
+      mesh.indicies.size() % 3 != 0) {
+    return false;
+  }
+  shape.boundsMin = mesh.boundsMin;
+  shape.boundsMax = mesh.boundsMax;
+  shape.width = mesh.width;
+  shape.height = mesh.height;
+  return true;
+}
+
+Game::Game() {}
+
+void Game::setup(const GameShapes &shapes, const GameObject &padTemplate,
+                 const GameObject &ballTemplate,
+                 const GameObject &blockTemplate, uint64_t seed) {
+  m_shapes = shapes;
+  m_random.seed(seed);
+  pad = padTemplate;
+  pad.movement = glm::vec3(800.0f, 100.0f, 200.0f);
+  ball = ballTemplate;
+  ball.movement = glm::vec3(800.0f, 200.0f, 200.0f);
+  score = 0;
+  ticks = 0;
+  m_destroyed.clear();
+  generateBlocks(blockTemplate);
+
+  Aabb field{glm::vec2(0.0f), glm::vec2(fieldWidth, fieldHeight)};
+  m_world = CollisionWorld();
+  m_world.setField(field);
+  Aabb padBounds = objectBounds(shapes.pad, pad);
+  m_padBox = m_world.addBox(padBounds, true);
+  m_firstBlock = m_padBox + 1;
+  Aabb blockArea = padBounds;
+  for (size_t n = 0; n < blocks.size(); n++) {
+    Aabb bounds = objectBounds(shapes.block, blocks[n]);
+    m_world.addBox(bounds);
+    blockArea.min = n == 0 ? bounds.min : glm::min(blockArea.min, bounds.min);
+    blockArea.max = n == 0 ? bounds.max : glm::max(blockArea.max, bounds.max);
+  }
+  m_obstacles = {blockArea, padBounds};
+  // blocks are looked up by grid cell instead of scanning all of them
+  m_world.buildBroadphase();
+  m_blocksLeft = blocks.size();
+
+  balls.setup((shapes.ball.boundsMax.x - shapes.ball.boundsMin.x) / 2.0f *
+                  ball.scale.x,
+              field);
+  balls.add(glm::vec2(ball.movement.x, ball.movement.y),
+            launchVelocity(m_random));
+}
+
+void Game::tick(float padDirection, float dt, JobSystem *jobs) {
+  pad.movement.x += padDirection * dt * padSpeed;
+
+  float padWidth = m_shapes.pad.width;
+  if (pad.movement.x < 0 + padWidth) {
+    pad.movement.x = padWidth;
+  }
+  if (pad.movement.x > fieldWidth - padWidth) {
+    pad.movement.x = fieldWidth - padWidth;
+  }
+  m_obstacles[1] = objectBounds(m_shapes.pad, pad);
+  m_world.moveBox(m_padBox, m_obstacles[1]);
+
+  // continuous collision against the walls, the pad and the blocks
+  m_hits.clear();
+  if (jobs != nullptr) {
+    balls.update(m_world, m_obstacles, dt, m_hits, *jobs);
+  } else {
+    balls.update(m_world, m_obstacles, dt, m_hits);
+  }
+
+  for (auto boxId : m_hits) {
+    if (boxId < m_firstBlock || !m_world.isAlive(boxId)) {
+      continue;
+    }
+    m_world.removeBox(boxId);
+    // hidden by scaling it away, the block keeps its index
+    auto &block = blocks[boxId - m_firstBlock];
+    block.scale = glm::vec3(0.0f);
+    m_destroyed.push_back(boxId - m_firstBlock);
+    m_blocksLeft--;
+    score += blockPoints;
+  }
+  ticks++;
+}
+
+void Game::spawnBalls(uint32_t count) {
+  count = std::min(count, maxBalls - std::min(balls.size(), maxBalls));
+  for (uint32_t n = 0; n < count; n++) {
+    balls.add(glm::vec2(pad.movement.x, ball.movement.y),
+              launchVelocity(m_random));
+  }
+}
+
+// rows of blocks across the top of the field
+void Game::generateBlocks(const GameObject &blockTemplate) {
+  GameObject block = blockTemplate;
+  block.movement = glm::vec3(0.0f, 1050.0f, 200.0f);
+  blocks.clear();
+
+  auto blockWidth = m_shapes.block.width * block.scale.x;
+  auto blockHeight = m_shapes.block.height * block.scale.y;
+  for (int n = 0; n < 10; n++) {
+    for (int i = 0; i < (fieldWidth / (blockWidth + 4) - 1); i++) {
+      block.movement.x = i * (blockWidth + 4) + blockWidth / 1.5f;
+      block.movement.y = 1050 - (n * (blockHeight + 4) + blockHeight / 1.5f);
+      blocks.emplace_back(block);
+    }
+  }
+}
+
+glm::vec2 Game::launchVelocity(Random &random) {
+  // 30 to 60 degrees off the pad, so the first bounce never runs flat
+  float angle = random.uniform(0.5236f, 1.0472f);
+  float side = (random.next() & 1) ? 1.0f : -1.0f;
+  return launchSpeed * glm::vec2(side * std::cos(angle), std::sin(angle));
+}
+
+Aabb Game::objectBounds(const Shape &shape, const GameObject &obj) {
+  glm::vec2 position(obj.movement.x, obj.movement.y);
+  glm::vec2 scale(obj.scale.x, obj.scale.y);
+  return Aabb{
+      position + glm::vec2(shape.boundsMin.x, shape.boundsMin.y) * scale,
+      position + glm::vec2(shape.boundsMax.x, shape.boundsMax.y) * scale};
+}
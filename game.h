@@ -0,0 +1,95 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "ballsystem.h"
+#include "collision.h"
+#include "gameobject.h"
+#include "jobsystem.h"
+#include "random.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Size of a model as the simulation sees it, the same fields as the mesh
+// it is drawn with so the game does not need the GL side to be loaded.
+struct Shape {
+  glm::vec3 boundsMin{0.0f};
+  glm::vec3 boundsMax{0.0f};
+  float width{0};
+  float height{0};
+};
+
+struct GameShapes {
+  Shape pad;
+  Shape ball;
+  Shape block;
+};
+
+// Reads the shape of an .obj file from its mesh cache when that is fresh,
+// otherwise by parsing the file. False when the file cannot be read or is
+// not a whole triangle list, like an empty or truncated file.
+bool readShape(const std::string &filename, Shape &shape);
+
+// Breakout game state and rules without any window or GL dependency: pad,
+// balls, blocks, collisions and score, advanced in fixed ticks. The objects
+// keep the render ids and scale of the templates they were set up from, so
+// the windowed build draws them straight away. The balls live in a
+// BallSystem, ball is the object they are drawn as and where they start.
+class Game {
+public:
+  // simulation ticks per second unless --tick-rate says otherwise,
+  // independent of the frame rate
+  static constexpr double defaultTickRate = 120.0;
+  static constexpr float fieldWidth = 1600.0f;
+  static constexpr float fieldHeight = 1100.0f;
+  static constexpr float padSpeed = 750.0f;
+  static constexpr uint32_t blockPoints = 10;
+  // speed of the old fixed (400, 400) launch
+  static constexpr float launchSpeed = 565.685f;
+  // balls the renderer makes room for, spawnBalls() stops there
+  static constexpr uint32_t maxBalls = 65536;
+
+  Game();
+
+  void setup(const GameShapes &shapes, const GameObject &padTemplate,
+             const GameObject &ballTemplate, const GameObject &blockTemplate,
+             uint64_t seed = 0);
+  // padDirection is -1, 0 or 1, dt the fixed tick length. Given jobs, many
+  // balls are moved on all of its threads.
+  void tick(float padDirection, float dt, JobSystem *jobs = nullptr);
+  // launches count more balls from above the pad
+  void spawnBalls(uint32_t count);
+
+  // blocks destroyed since the last clearDestroyed(), as indices in blocks
+  const std::vector<uint32_t> &destroyed() const { return m_destroyed; }
+  void clearDestroyed() { m_destroyed.clear(); }
+  bool isCleared() const { return m_blocksLeft == 0; }
+
+  // ball velocity at the start of a game, up and to a random side
+  static glm::vec2 launchVelocity(Random &random);
+  // box an object covers in the play field plane
+  static Aabb objectBounds(const Shape &shape, const GameObject &obj);
+
+  GameObject pad;
+  GameObject ball;
+  BallSystem balls;
+  std::vector<GameObject> blocks;
+  uint32_t score{0};
+  uint64_t ticks{0};
+
+private:
+  void generateBlocks(const GameObject &blockTemplate);
+
+  GameShapes m_shapes;
+  Random m_random;
+  CollisionWorld m_world;
+  uint32_t m_padBox{0};
+  uint32_t m_firstBlock{0};
+  uint32_t m_blocksLeft{0};
+  // block area and pad, the balls clear of both skip the collision world
+  std::vector<Aabb> m_obstacles;
+  std::vector<uint32_t> m_hits;
+  std::vector<uint32_t> m_destroyed;
+};
+
+#endif // GAME_H
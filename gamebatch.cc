@@ -0,0 +1,168 @@
+#include "gamebatch.h"
+#include "collision.h"
+
+#include <algorithm>
+
+GameBatch::GameBatch() {}
+
+void GameBatch::setup(const GameShapes &shapes, size_t count, uint64_t seed,
+                      double tickRate) {
+  // a single game lays out the field every game of the batch starts from
+  Game layout;
+  layout.setup(shapes, GameObject(), GameObject(), GameObject());
+
+  m_field = Aabb{glm::vec2(0.0f), glm::vec2(Game::fieldWidth, Game::fieldHeight)};
+  m_padStart = glm::vec2(layout.pad.movement.x, layout.pad.movement.y);
+  m_ballStart = glm::vec2(layout.ball.movement.x, layout.ball.movement.y);
+  GameObject origin = layout.pad;
+  origin.movement = glm::vec3(0.0f);
+  m_padShape = Game::objectBounds(shapes.pad, origin);
+  m_padY = m_padStart.y;
+  m_padWidth = shapes.pad.width;
+  m_ballRadius = (shapes.ball.boundsMax.x - shapes.ball.boundsMin.x) / 2.0f *
+                 layout.ball.scale.x;
+  // the same float tick length FixedTimestep hands to Game::tick
+  m_dt = (float)(1.0 / tickRate);
+
+  m_blocks.clear();
+  std::vector<uint32_t> ids;
+  glm::vec2 cellSize{0.0f};
+  for (const auto &block : layout.blocks) {
+    ids.push_back(m_blocks.size());
+    m_blocks.push_back(Game::objectBounds(shapes.block, block));
+    cellSize = glm::max(cellSize, m_blocks.back().max - m_blocks.back().min);
+  }
+  // the same grid CollisionWorld builds for the blocks
+  m_grid.build(m_blocks, ids, glm::max(cellSize, glm::vec2(1.0f)));
+  m_words = (m_blocks.size() + 63) / 64;
+
+  m_padX.assign(count, 0.0f);
+  m_ballX.assign(count, 0.0f);
+  m_ballY.assign(count, 0.0f);
+  m_velocityX.assign(count, 0.0f);
+  m_velocityY.assign(count, 0.0f);
+  m_score.assign(count, 0);
+  m_blocksLeft.assign(count, 0);
+  m_ticks.assign(count, 0);
+  m_rewards.assign(count, 0.0f);
+  m_done.assign(count, 0);
+  m_random.assign(count, Random());
+  m_alive.assign(count * m_words, 0);
+  m_scratch.assign((count + chunkSize - 1) / chunkSize, Scratch());
+
+  for (size_t index = 0; index < count; index++) {
+    reset(index, seed + index);
+  }
+}
+
+void GameBatch::reset(size_t index, uint64_t seed) {
+  m_random[index].seed(seed);
+  glm::vec2 velocity = Game::launchVelocity(m_random[index]);
+
+  m_padX[index] = m_padStart.x;
+  m_ballX[index] = m_ballStart.x;
+  m_ballY[index] = m_ballStart.y;
+  m_velocityX[index] = velocity.x;
+  m_velocityY[index] = velocity.y;
+  m_score[index] = 0;
+  m_blocksLeft[index] = m_blocks.size();
+  m_ticks[index] = 0;
+  m_done[index] = 0;
+
+  uint64_t *alive = &m_alive[index * m_words];
+  std::fill(alive, alive + m_words, ~0ull);
+  if (m_blocks.size() % 64 != 0) {
+    alive[m_words - 1] = (1ull << (m_blocks.size() % 64)) - 1;
+  }
+}
+
+void GameBatch::step(const float *padDirections, uint32_t ticks,
+                     ThreadPool &pool) {
+  pool.parallelFor(m_scratch.size(), [&](size_t chunk) {
+    size_t first = chunk * chunkSize;
+    size_t last = std::min(first + chunkSize, size());
+    for (size_t index = first; index < last; index++) {
+      if (m_done[index]) {
+        reset(index, m_random[index].next());
+      }
+      m_rewards[index] = 0.0f;
+      for (uint32_t n = 0; n < ticks && !m_done[index]; n++) {
+        tick(index, padDirections[index], m_scratch[chunk]);
+      }
+    }
+  });
+}
+
+void GameBatch::observe(float *observations) const {
+  for (size_t index = 0; index < size(); index++) {
+    float *out = observations + index * observationSize;
+    out[0] = m_padX[index];
+    out[1] = m_ballX[index];
+    out[2] = m_ballY[index];
+    out[3] = m_velocityX[index];
+    out[4] = m_velocityY[index];
+    out[5] = (float)m_blocksLeft[index];
+  }
+}
+
+// Game::tick on one game of the batch, the pad is the only dynamic box
+// like in Game's CollisionWorld and gets the id after the last block
+void GameBatch::tick(size_t index, float padDirection, Scratch &scratch) {
+  float padX = m_padX[index] + padDirection * m_dt * Game::padSpeed;
+  if (padX < 0 + m_padWidth) {
+    padX = m_padWidth;
+  }
+  if (padX > Game::fieldWidth - m_padWidth) {
+    padX = Game::fieldWidth - m_padWidth;
+  }
+  m_padX[index] = padX;
+  glm::vec2 padPosition(padX, m_padY);
+  Aabb pad{padPosition + m_padShape.min, padPosition + m_padShape.max};
+  uint32_t padId = m_blocks.size();
+
+  glm::vec2 position(m_ballX[index], m_ballY[index]);
+  glm::vec2 velocity(m_velocityX[index], m_velocityY[index]);
+  scratch.hits.clear();
+  moveBallThrough(
+      position, velocity, m_ballRadius, m_dt, m_field, scratch.hits,
+      scratch.candidates,
+      [this, padId](glm::vec2 start, glm::vec2 delta,
+                    std::vector<uint32_t> &ids) {
+        ids.push_back(padId);
+        m_grid.queryShared(start, delta, m_ballRadius, ids);
+      },
+      [this, index, padId, &pad](uint32_t box, Aabb &bounds) {
+        if (box == padId) {
+          bounds = pad;
+          return true;
+        }
+        if (!isAlive(index, box)) {
+          return false;
+        }
+        bounds = m_blocks[box];
+        return true;
+      });
+  m_ballX[index] = position.x;
+  m_ballY[index] = position.y;
+  m_velocityX[index] = velocity.x;
+  m_velocityY[index] = velocity.y;
+
+  for (auto block : scratch.hits) {
+    if (block == padId) {
+      continue;
+    }
+    uint64_t &word = m_alive[index * m_words + block / 64];
+    uint64_t bit = 1ull << (block % 64);
+    if ((word & bit) == 0) {
+      continue;
+    }
+    word &= ~bit;
+    m_blocksLeft[index]--;
+    m_score[index] += Game::blockPoints;
+    m_rewards[index] += Game::blockPoints;
+  }
+  m_ticks[index]++;
+  if (m_blocksLeft[index] == 0) {
+    m_done[index] = 1;
+  }
+}
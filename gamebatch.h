@@ -0,0 +1,93 @@
+#ifndef GAMEBATCH_H
+#define GAMEBATCH_H
+
+#include "aabb.h"
+#include "boxgrid.h"
+#include "game.h"
+#include "random.h"
+#include "threadpool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Many independent headless games stepped together, for training agents
+// and balance testing. Every game follows the rules and layout of Game, but
+// the state is kept as one array per field and the block boxes and their
+// grid are shared, a game only owns a bitset of the blocks still standing.
+// Games are stepped in chunks on a ThreadPool, each with its own Random, so
+// the results do not depend on the thread count.
+class GameBatch {
+public:
+  // floats per game written by observe()
+  static constexpr uint32_t observationSize = 6;
+  // games one pool task steps
+  static constexpr uint32_t chunkSize = 64;
+
+  GameBatch();
+
+  // count games, game n seeded with seed + n, ticking tickRate times a
+  // simulated second
+  void setup(const GameShapes &shapes, size_t count, uint64_t seed = 0,
+             double tickRate = Game::defaultTickRate);
+  // starts game index over with a fresh field and a launch drawn from seed
+  void reset(size_t index, uint64_t seed);
+  // Advances every game by ticks fixed ticks, padDirections[n] (-1 to 1)
+  // held by game n. A game that ended in the previous step starts over
+  // first, seeded from its own generator.
+  void step(const float *padDirections, uint32_t ticks, ThreadPool &pool);
+  // Writes observationSize floats per game: pad x, ball x and y, ball
+  // velocity x and y and the number of blocks left.
+  void observe(float *observations) const;
+
+  size_t size() const { return m_padX.size(); }
+  uint32_t blockCount() const { return m_blocks.size(); }
+  // points each game scored during the last step
+  const std::vector<float> &rewards() const { return m_rewards; }
+  // 1 for the games that ended during the last step
+  const std::vector<uint8_t> &done() const { return m_done; }
+  uint32_t score(size_t index) const { return m_score[index]; }
+  uint32_t ticks(size_t index) const { return m_ticks[index]; }
+  bool isAlive(size_t index, uint32_t block) const {
+    return (m_alive[index * m_words + block / 64] >> (block % 64)) & 1;
+  }
+
+private:
+  // per task buffers, so stepping never allocates
+  struct Scratch {
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> hits;
+  };
+
+  void tick(size_t index, float padDirection, Scratch &scratch);
+
+  // shared by every game
+  Aabb m_field;
+  Aabb m_padShape; // pad box around its position
+  float m_padY{0};
+  float m_padWidth{0};
+  float m_ballRadius{0};
+  glm::vec2 m_padStart{0.0f};
+  glm::vec2 m_ballStart{0.0f};
+  float m_dt{0};
+  std::vector<Aabb> m_blocks;
+  BoxGrid m_grid;
+  uint32_t m_words{0}; // alive bitset words per game
+
+  // one entry per game
+  std::vector<float> m_padX;
+  std::vector<float> m_ballX;
+  std::vector<float> m_ballY;
+  std::vector<float> m_velocityX;
+  std::vector<float> m_velocityY;
+  std::vector<uint32_t> m_score;
+  std::vector<uint32_t> m_blocksLeft;
+  std::vector<uint32_t> m_ticks;
+  std::vector<float> m_rewards;
+  std::vector<uint8_t> m_done;
+  std::vector<Random> m_random;
+  std::vector<uint64_t> m_alive; // m_words per game
+
+  std::vector<Scratch> m_scratch;
+};
+
+#endif // GAMEBATCH_H
@@ -0,0 +1,164 @@
+#include "headless.h"
+#include "fixedtimestep.h"
+#include "game.h"
+#include "gamebatch.h"
+#include "threadpool.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+bool readShapes(const std::string &assetDir, GameShapes &shapes) {
+  std::pair<const char *, Shape *> models[] = {{"pad.obj", &shapes.pad},
+                                               {"ball.obj", &shapes.ball},
+                                               {"block.obj", &shapes.block}};
+  for (auto [name, shape] : models) {
+    auto filename = (std::filesystem::path(assetDir) / name).string();
+    if (!readShape(filename, *shape)) {
+      std::cerr << "Error could not read the game model " << filename
+                << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+int runHeadless(const Options &options) {
+  GameShapes shapes;
+  if (!readShapes(options.assetDir, shapes)) {
+    return 1;
+  }
+
+  Game game;
+  game.setup(shapes, GameObject(), GameObject(), GameObject());
+  // same tick length as the windowed game
+  FixedTimestep timestep(options.tickRate);
+  if (options.balls > 1) {
+    game.spawnBalls(options.balls - 1);
+  }
+  uint64_t ticks = options.ticks;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t tick = 0; tick < ticks; tick++) {
+    // the pad follows the first ball
+    float offset = game.balls.position(0).x - game.pad.movement.x;
+    float direction = offset > 8.0f ? 1.0f : (offset < -8.0f ? -1.0f : 0.0f);
+    game.tick(direction, timestep.dt());
+    game.clearDestroyed();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::cout << "headless: " << ticks << " ticks in " << elapsed.count()
+            << " s, " << ticks / elapsed.count() << " ticks/s, score "
+            << game.score << ", " << game.balls.size() << " balls, "
+            << game.ticks * timestep.dt()
+            << " s simulated" << std::endl;
+  return 0;
+}
+
+int runHeadlessBatch(const Options &options) {
+  GameShapes shapes;
+  if (!readShapes(options.assetDir, shapes)) {
+    return 1;
+  }
+
+  size_t games = options.games;
+  uint64_t ticks = options.ticks;
+  ThreadPool pool;
+  GameBatch batch;
+  batch.setup(shapes, games, 1, options.tickRate);
+  std::vector<float> padDirections(games, 0.0f);
+  Random random(games);
+  // each step holds the pad directions for a few ticks, like an agent would
+  constexpr uint32_t ticksPerStep = 4;
+
+  uint64_t score{0};
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t tick = 0; tick < ticks; tick += ticksPerStep) {
+    for (auto &direction : padDirections) {
+      direction = random.uniform(-1.0f, 1.0f);
+    }
+    batch.step(padDirections.data(), ticksPerStep, pool);
+    for (auto reward : batch.rewards()) {
+      score += (uint64_t)reward;
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  double total = (double)games * ((ticks + ticksPerStep - 1) / ticksPerStep) *
+                 ticksPerStep;
+  std::cout << "headless batch: " << games << " games on " << pool.size()
+            << " threads, " << total << " ticks in " << elapsed.count()
+            << " s, " << total / elapsed.count() << " ticks/s, score "
+            << score << std::endl;
+  return 0;
+}
+
+int runHeadlessCompare(const Options &options) {
+  GameShapes shapes;
+  if (!readShapes(options.assetDir, shapes)) {
+    return 1;
+  }
+
+  size_t count = options.games;
+  ThreadPool pool;
+  GameBatch batch;
+  batch.setup(shapes, count, 1, options.tickRate);
+  FixedTimestep timestep(options.tickRate);
+  std::vector<Game> games(count);
+  for (size_t n = 0; n < count; n++) {
+    // seeded like game n of the batch
+    games[n].setup(shapes, GameObject(), GameObject(), GameObject(), 1 + n);
+  }
+  std::vector<float> padDirections(count, 0.0f);
+  std::vector<float> observations(count * GameBatch::observationSize);
+  // the batch starts a game over once it ends, the comparison stops there
+  std::vector<uint8_t> ended(count, 0);
+  Random random(count);
+  constexpr uint32_t ticksPerStep = 4;
+
+  for (uint64_t tick = 0; tick < options.ticks; tick += ticksPerStep) {
+    for (auto &direction : padDirections) {
+      direction = random.uniform(-1.0f, 1.0f);
+    }
+    batch.step(padDirections.data(), ticksPerStep, pool);
+    batch.observe(observations.data());
+
+    for (size_t n = 0; n < count; n++) {
+      if (ended[n]) {
+        continue;
+      }
+      auto &game = games[n];
+      for (uint32_t step = 0; step < ticksPerStep && !game.isCleared();
+           step++) {
+        game.tick(padDirections[n], timestep.dt());
+        game.clearDestroyed();
+      }
+      const float *observed = &observations[n * GameBatch::observationSize];
+      glm::vec2 position = game.balls.position(0);
+      glm::vec2 velocity = game.balls.velocity(0);
+      if (observed[0] != game.pad.movement.x || observed[1] != position.x ||
+          observed[2] != position.y || observed[3] != velocity.x ||
+          observed[4] != velocity.y || batch.score(n) != game.score) {
+        std::cerr << "Error game " << n << " differs after " << game.ticks
+                  << " ticks: ball (" << observed[1] << ", " << observed[2]
+                  << ") score " << batch.score(n) << " in the batch, ball ("
+                  << position.x << ", " << position.y << ") score "
+                  << game.score << " alone" << std::endl;
+        return 1;
+      }
+      ended[n] = batch.done()[n];
+    }
+  }
+
+  std::cout << "compare: " << count << " games matched Game bit for bit over "
+            << options.ticks << " ticks" << std::endl;
+  return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "options.h"
+
+// Runs the game for options.ticks fixed ticks without a window or GL
+// context, the pad following the first of options.balls balls, and prints
+// the simulation throughput. Returns the process exit code.
+int runHeadless(const Options &options);
+// Same for options.games independent games stepped together as a GameBatch
+// on every core, each with its own seed and a random pad.
+int runHeadlessBatch(const Options &options);
+// Runs the options.games games of runHeadlessBatch() as a GameBatch and as
+// separate Game objects with the same seeds and pad input. Both have to
+// match bit for bit, ball positions, velocities, pad and score, or the
+// function fails. That covers the SIMD ball kernel against moveBall.
+int runHeadlessCompare(const Options &options);
+
+#endif // HEADLESS_H
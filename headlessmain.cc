@@ -0,0 +1,21 @@
+// Entry point of breakout_headless, the game without window or GL for
+// machines without a GPU or glfw. Takes the options of the windowed game,
+// see options.h, without any it runs a million ticks of one game.
+
+#include "headless.h"
+
+int main(int argc, char *argv[]) {
+  Options options;
+  options.mode = Options::Mode::Headless;
+  options.ticks = 1000000;
+  if (!parseOptions(argc, argv, options)) {
+    return 1;
+  }
+  if (options.mode == Options::Mode::Batch) {
+    return runHeadlessBatch(options);
+  }
+  if (options.mode == Options::Mode::Compare) {
+    return runHeadlessCompare(options);
+  }
+  return runHeadless(options);
+}
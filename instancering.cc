@@ -0,0 +1,98 @@
+#include "glad.h"
+
+#include "instancering.h"
+
+#include <iostream>
+
+InstanceRing::InstanceRing() {}
+
+void InstanceRing::setup(uint32_t capacity) {
+  m_capacity = capacity;
+  m_region = regionCount - 1; // the first beginFrame moves to region 0
+  m_used = m_committed = 0;
+
+  GLsizeiptr size = (GLsizeiptr)regionCount * capacity * sizeof(glm::mat4);
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+  // buffer storage is core in 4.4, our 4.3 context needs the extension
+  if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage) {
+    GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+    m_mapped = (glm::mat4 *)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+  }
+  if (m_mapped == nullptr) {
+    std::cout << "No persistent buffer mapping, instance data is copied"
+              << std::endl;
+    glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    m_staging.resize((size_t)regionCount * capacity);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceRing::beginFrame() {
+  m_region = (m_region + 1) % regionCount;
+  m_used = m_committed = 0;
+
+  GLsync fence = (GLsync)m_fences[m_region];
+  if (fence == nullptr) {
+    return;
+  }
+  // normally signaled long ago, only blocks when the GPU is frames behind
+  GLenum result;
+  do {
+    result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+  } while (result == GL_TIMEOUT_EXPIRED);
+  glDeleteSync(fence);
+  m_fences[m_region] = nullptr;
+}
+
+glm::mat4 *InstanceRing::allocate(uint32_t count, uint32_t &baseInstance) {
+  if (m_used + count > m_capacity) {
+    std::cout << "Instance ring full, " << count << " instances dropped"
+              << std::endl;
+    return nullptr;
+  }
+  baseInstance = m_region * m_capacity + m_used;
+  m_used += count;
+
+  return m_mapped ? m_mapped + baseInstance : &m_staging[baseInstance];
+}
+
+void InstanceRing::commit() {
+  if (m_mapped || m_used == m_committed) {
+    return; // coherent mapping, the writes are already visible
+  }
+  uint32_t first = m_region * m_capacity + m_committed;
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+  glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::mat4),
+                  (m_used - m_committed) * sizeof(glm::mat4),
+                  &m_staging[first]);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  m_committed = m_used;
+}
+
+void InstanceRing::endFrame() {
+  if (m_mapped) {
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+}
+
+void InstanceRing::release() {
+  for (auto &fence : m_fences) {
+    if (fence) {
+      glDeleteSync((GLsync)fence);
+      fence = nullptr;
+    }
+  }
+  if (m_mapped) {
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_mapped = nullptr;
+  }
+  glDeleteBuffers(1, &m_buffer);
+  m_buffer = 0;
+  m_staging.clear();
+}
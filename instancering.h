@@ -0,0 +1,46 @@
+#ifndef INSTANCERING_H
+#define INSTANCERING_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Per instance model matrices for every draw of a frame. The buffer is split
+// into regionCount regions that are written in turn through a persistent,
+// coherent mapping, a fence per region keeps the CPU from overwriting
+// matrices the GPU has not read yet. Draws address their matrices through
+// the baseInstance returned by allocate().
+class InstanceRing {
+public:
+  static constexpr uint32_t regionCount = 3;
+
+  InstanceRing();
+
+  // capacity is the number of matrices one frame may use
+  void setup(uint32_t capacity);
+  // waits for the GPU to finish with the next region and starts filling it
+  void beginFrame();
+  // count consecutive matrices, nullptr when the frame is full
+  glm::mat4 *allocate(uint32_t count, uint32_t &baseInstance);
+  // makes this frame's matrices visible, call before drawing
+  void commit();
+  // fences the region once the frame's draws are submitted
+  void endFrame();
+  void release();
+
+  uint32_t buffer() const { return m_buffer; }
+  uint32_t region() const { return m_region; }
+
+private:
+  uint32_t m_buffer{0};
+  uint32_t m_capacity{0};
+  uint32_t m_region{0};
+  uint32_t m_used{0};
+  uint32_t m_committed{0};
+  glm::mat4 *m_mapped{nullptr};
+  // written with glBufferSubData when buffer storage is missing
+  std::vector<glm::mat4> m_staging;
+  void *m_fences[regionCount]{};
+};
+
+#endif // INSTANCERING_H
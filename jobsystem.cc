@@ -0,0 +1,153 @@
+#include "jobsystem.h"
+
+#include <algorithm>
+
+namespace {
+// JobSystem the running thread is a worker of and the queue it owns there
+thread_local const JobSystem *currentSystem = nullptr;
+thread_local uint32_t currentQueue = 0;
+} // namespace
+
+JobSystem::JobSystem(uint32_t threads) {
+  threads = std::max<uint32_t>(threads, 1);
+  for (uint32_t n = 0; n < threads; n++) {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+  for (uint32_t n = 1; n < threads; n++) {
+    m_threads.emplace_back([this, n] { worker(n); });
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+}
+
+Job *JobSystem::create(std::function<void()> task, Job *parent) {
+  auto &queue = *m_queues[queueIndex()];
+  Job *job;
+  {
+    // a thread outside of the system shares queue 0 with the owner
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    job = &queue.storage.emplace_back();
+  }
+  job->task = std::move(task);
+  job->parent = parent;
+  if (parent != nullptr) {
+    parent->unfinished++;
+  }
+  return job;
+}
+
+void JobSystem::run(Job *job) {
+  // counted before it can be popped, so m_queued never drops below 0
+  m_queued++;
+  auto &queue = *m_queues[queueIndex()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back(job);
+  }
+  if (!m_threads.empty()) {
+    // taking the lock orders this with a worker about to sleep
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_wake.notify_one();
+  }
+}
+
+void JobSystem::wait(Job *job) {
+  while (job->unfinished > 0) {
+    Job *other = next(queueIndex());
+    if (other != nullptr) {
+      execute(other);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::runRanges(size_t count, size_t grain, Job *parent,
+                          const std::function<void(size_t, size_t)> &task) {
+  grain = std::max<size_t>(grain, 1);
+  for (size_t first = 0; first < count; first += grain) {
+    size_t last = std::min(first + grain, count);
+    run(create([task, first, last] { task(first, last); }, parent));
+  }
+}
+
+void JobSystem::reset() {
+  for (auto &queue : m_queues) {
+    queue->storage.clear();
+  }
+}
+
+// queue of the running thread, 0 for the owner and for threads that are not
+// workers of this system, like those of another JobSystem
+uint32_t JobSystem::queueIndex() const {
+  return currentSystem == this ? currentQueue : 0;
+}
+
+void JobSystem::worker(uint32_t index) {
+  currentSystem = this;
+  currentQueue = index;
+  while (true) {
+    Job *job = next(index);
+    if (job != nullptr) {
+      execute(job);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_wake.wait(lock, [this] { return m_stop || m_queued > 0; });
+    if (m_stop) {
+      return;
+    }
+  }
+}
+
+// newest job of the own queue, else the oldest of another one
+Job *JobSystem::next(uint32_t index) {
+  if (m_queued == 0) {
+    return nullptr;
+  }
+  {
+    auto &queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.jobs.empty()) {
+      Job *job = queue.jobs.back();
+      queue.jobs.pop_back();
+      m_queued--;
+      return job;
+    }
+  }
+  for (uint32_t n = 1; n < m_queues.size(); n++) {
+    auto &queue = *m_queues[(index + n) % m_queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.jobs.empty()) {
+      Job *job = queue.jobs.front();
+      queue.jobs.pop_front();
+      m_queued--;
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+void JobSystem::execute(Job *job) {
+  if (job->task) {
+    job->task();
+  }
+  finish(job);
+}
+
+void JobSystem::finish(Job *job) {
+  // the job memory must not be touched once its count reached 0
+  Job *parent = job->parent;
+  if (--job->unfinished == 0 && parent != nullptr) {
+    finish(parent);
+  }
+}
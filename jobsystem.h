@@ -0,0 +1,75 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One task of a job graph. A job counts as unfinished until its task has
+// run and every child created under it has finished, so waiting on a root
+// job waits for everything spawned below it.
+struct Job {
+  std::function<void()> task;
+  Job *parent{nullptr};
+  std::atomic<uint32_t> unfinished{1};
+};
+
+// Work-stealing scheduler for the jobs of a frame. Every thread has its own
+// deque, it pushes and pops the newest jobs at the back while idle threads
+// steal the oldest from the front of the others. The thread that made the
+// JobSystem is thread 0 and runs jobs while it waits, the others sleep when
+// there is nothing to steal. Jobs live until reset(), which is called once
+// per frame when the graph is done.
+class JobSystem {
+public:
+  JobSystem(uint32_t threads = std::thread::hardware_concurrency());
+  ~JobSystem();
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  // threads running jobs, including the owning thread
+  uint32_t size() const { return m_threads.size() + 1; }
+
+  // A job that is not started until run(). Children must be created before
+  // their parent finishes, from the owning thread or from inside a job.
+  Job *create(std::function<void()> task, Job *parent = nullptr);
+  void run(Job *job);
+  // runs jobs until job and all its children have finished
+  void wait(Job *job);
+  // runs task(first, last) over count items in ranges of grain items, each
+  // range a child job of parent
+  void runRanges(size_t count, size_t grain, Job *parent,
+                 const std::function<void(size_t, size_t)> &task);
+  // frees every job, only while none is queued or running
+  void reset();
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Job *> jobs;
+    std::deque<Job> storage; // jobs created through this queue
+  };
+
+  uint32_t queueIndex() const;
+  void worker(uint32_t index);
+  Job *next(uint32_t index);
+  void execute(Job *job);
+  void finish(Job *job);
+
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_threads;
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wake;
+  std::atomic<uint32_t> m_queued{0};
+  bool m_stop{false};
+};
+
+#endif // JOBSYSTEM_H
@@ -1,40 +1,79 @@
 #include "glad.h" // must be before glfw.h
-#include "wavefrontreader.h"
 
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <filesystem>
 #include <iostream>
+#include <string>
 #include <stdlib.h>
 #include <time.h>
+#include <unordered_map>
 #include <vector>
 
+#include "assetregistry.h"
+#include "ballrenderer.h"
+#include "blockrenderer.h"
+#include "fixedtimestep.h"
+#include "frameuniforms.h"
+#include "game.h"
 #include "gameobject.h"
+#include "headless.h"
+#include "jobsystem.h"
+#include "renderqueue.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-constexpr int32_t SCREEN_WIDTH = 1600;
-constexpr int32_t SCREEN_HEIGHT = 1100;
+constexpr int32_t SCREEN_WIDTH = (int32_t)Game::fieldWidth;
+constexpr int32_t SCREEN_HEIGHT = (int32_t)Game::fieldHeight;
 constexpr float fov = glm::radians(90.0f);
+// false renders as fast as possible, the simulation rate stays the same
+constexpr bool vsync = true;
 
+// vertex shaders are compiled with PACKED_VERTICES defined for meshes
+// uploaded as PackedVertex, positions then arrive normalized to the mesh
+// bounds and the model matrix scales them back. Every draw is instanced, the
+// model matrix is a per instance attribute fed from the instance ring.
 constexpr auto vertexShaderSource = R"(
 #version 430 core
 layout (location = 0) in vec3 aPos;
+#ifdef PACKED_VERTICES
+layout (location = 1) in vec2 aNormal;
+#else
 layout (location = 1) in vec3 aNormal;
+#endif
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aModel;
 
 out vec2 TexCoords;
+out vec3 Normal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec4 viewport;
+    float time;
+};
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
 
 void main()
 {
     TexCoords = aTexCoords;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+#ifdef PACKED_VERTICES
+    Normal = octDecode(aNormal);
+#else
+    Normal = aNormal;
+#endif
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
 }
 )";
 
@@ -52,50 +91,17 @@ void main()
 }
 )";
 
-unsigned int loadShaders(const char *shaderSource, GLenum shaderType) {
-
-  unsigned int shader{0};
-  int success{0};
-  char infoLog[1024];
-
-  shader = glCreateShader(shaderType); // GL_VERTEX_SHADER
-
-  glShaderSource(shader, 1, &shaderSource, NULL);
-  glCompileShader(shader);
-  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-
-  if (!success) {
-    glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-    std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-              << infoLog << std::endl;
-  }
-  return shader;
-}
-
-unsigned int makeShaderProgram(uint32_t vertexShader, uint32_t fragmentShader) {
-  unsigned int shaderProgram;
-  int success{0};
-  char infoLog[4096];
-
-  shaderProgram = glCreateProgram();
-  glAttachShader(shaderProgram, vertexShader);
-  glAttachShader(shaderProgram, fragmentShader);
-  glLinkProgram(shaderProgram);
-
-  glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-  if (!success) {
-    glGetProgramInfoLog(shaderProgram, 4096, NULL, infoLog);
-    std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-              << infoLog << std::endl;
-  }
-
-  glDeleteShader(vertexShader);
-  glDeleteShader(fragmentShader);
-
-  return shaderProgram;
+const char *shaderDefines(VertexFormat format) {
+  return format == VertexFormat::Packed ? "#define PACKED_VERTICES\n" : "";
 }
 
 unsigned int loadImage(std::string filename) {
+  // objects sharing an image share the texture, so their draws can batch
+  static std::unordered_map<std::string, unsigned int> loaded;
+  auto found = loaded.find(filename);
+  if (found != loaded.end()) {
+    return found->second;
+  }
   int width, height, nrChannels;
 
   unsigned int texture;
@@ -118,6 +124,7 @@ unsigned int loadImage(std::string filename) {
   }
   stbi_image_free(data);
 
+  loaded[filename] = texture;
   return texture;
 }
 
@@ -145,10 +152,14 @@ void processInput(GLFWwindow *window) {
     glfwSetWindowShouldClose(window, true);
 }
 
-void camera(uint32_t shaderId) {
+float farPlane() {
+  return (SCREEN_WIDTH / 2.0f) / tanf(fov / 2.0f); // was 90.0f
+}
+
+glm::mat4 camera() {
   glm::mat4 view = glm::mat4(1.0f);
 
-  float zFar = (SCREEN_WIDTH / 2.0f) / tanf(fov / 2.0f); // was 90.0f
+  float zFar = farPlane();
   glm::vec3 cameraPos = glm::vec3(0 / 2.0f, 0 / 2.0f, zFar);
   glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
   // std::cout << " x= " << cameraPos.x << " y = " << cameraPos.y
@@ -159,140 +170,57 @@ void camera(uint32_t shaderId) {
   glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
   view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
 
-  int modelView = glGetUniformLocation(shaderId, "view");
-  glUniformMatrix4fv(modelView, 1, GL_FALSE, glm::value_ptr(view));
+  return view;
 }
 
-void renderObjs(GameObject &objs) {
-  float zFar = (SCREEN_WIDTH / 2.0f) / tanf(fov / 2.0f); // 100.0f
+glm::mat4 projection() {
+  float zFar = farPlane(); // 100.0f
 
   glm::mat4 projection = glm::ortho(0.0f, (float)SCREEN_WIDTH, 0.0f,
                                     (float)SCREEN_HEIGHT, 0.1f, zFar);
-  // 2. use our shader program when we want to render an object
-  glUseProgram(objs.shaderId);
-
-  int modelprj = glGetUniformLocation(objs.shaderId, "projection");
-  glUniformMatrix4fv(modelprj, 1, GL_FALSE, glm::value_ptr(projection));
-
-  camera(objs.shaderId);
-
-  // and finally bind the texture
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, objs.textureId);
-  glBindVertexArray(objs.VAO);
-
-  glm::mat4 model = glm::mat4(1.0f);
-  model = glm::translate(model, objs.movement);
-  /*   model =
-         glm::rotate(model, (float)glfwGetTime(), glm::vec3(1.0f,
-     0.0f, 1.0f));
- */
-  model = glm::scale(model, objs.scale);
-
-  int modelLoc = glGetUniformLocation(objs.shaderId, "model");
-  glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
 
-  glDrawElements(GL_TRIANGLES, objs.mesh.indicies.size(), GL_UNSIGNED_INT, 0);
-  glBindVertexArray(0);
-  glUseProgram(0);
+  return projection;
 }
 
-void CreateGameObject(GameObject &obj, std::string assetName,
-                      std::string assetMaterialName) {
-  WaveFrontReader reader(assetName);
-
-  reader.readVertices(obj.mesh);
-
-  glGenVertexArrays(1, &obj.VAO);
-
-  glGenBuffers(1, &obj.VBO);
-  glGenBuffers(1, &obj.EBO);
-
-  glBindVertexArray(obj.VAO);
-
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, obj.EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-               obj.mesh.indicies.size() * sizeof(uint32_t),
-               &obj.mesh.indicies[0], GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ARRAY_BUFFER, obj.VBO);
-  glBufferData(GL_ARRAY_BUFFER, obj.mesh.vertices.size() * sizeof(Vertex),
-               &obj.mesh.vertices[0], GL_STATIC_DRAW);
-
-  // vertex positions
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
-  // vertex normals
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                        (void *)offsetof(Vertex, Normal));
-  // vertex texture coords
-  glEnableVertexAttribArray(2);
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                        (void *)offsetof(Vertex, TextureCoords));
+void CreateGameObject(AssetRegistry &assets, GameObject &obj,
+                      std::string assetName, std::string assetMaterialName) {
+  obj.meshId = assets.loadMesh(assetName);
 
-  glEnableVertexAttribArray(0);
-  glBindVertexArray(0);
-
-  auto vertexShader = loadShaders(vertexShaderSource, GL_VERTEX_SHADER);
-  auto fragmentShader = loadShaders(fragmentShaderSource, GL_FRAGMENT_SHADER);
-
-  obj.shaderId = makeShaderProgram(vertexShader, fragmentShader);
+  obj.programId =
+      assets.loadProgram(vertexShaderSource, fragmentShaderSource,
+                         shaderDefines(assets.mesh(obj.meshId).format));
 
   if (assetMaterialName != "") {
     obj.textureId = loadImage(assetMaterialName);
 
-    glUseProgram(obj.shaderId);
     glActiveTexture(GL_TEXTURE0);
-    glUniform1i(glGetUniformLocation(obj.shaderId, "texture_diffuse1"), 0);
+    assets.program(obj.programId).set("texture_diffuse1", 0);
   }
-  glUseProgram(0);
-}
-
-std::vector<GameObject> generateBlocks(std::string objName,
-                                       std::string materialName) {
-  GameObject block;
-  std::vector<GameObject> retVal;
-
-  block.movement = glm::vec3(0.0f, 1050.0f, 200.0f);
-  CreateGameObject(block, objName, materialName);
-
-  auto blockWidth = block.mesh.width * block.scale.x;
-  auto blockHeight = block.mesh.height * block.scale.y;
-  std::cout << " block width = " << blockWidth << std::endl;
-  for (int n = 0; n < 10; n++) {
-    for (int i = 0; i < (SCREEN_WIDTH / (blockWidth + 4) - 1); i++) {
-      block.movement.x = i * (blockWidth + 4) + blockWidth / 1.5f;
-      block.movement.y = 1050 - (n * (blockHeight + 4) + blockHeight / 1.5f);
-
-      // std::cout << "[ " << block.movement.x << ", " << block.movement.y << ",
-      // "
-      //          << block.movement.z << " ]," << std::endl;
-      retVal.emplace_back(block);
-    }
-  }
-
-  return retVal;
 }
 
-void collision(glm::vec3 currPos, glm::vec3 newPos) {
-    auto va = newPos - currPos;
-    auto va_len = glm::length(va);
-    /*
-      x = start[0] + t/va_len*va[0]
-        y = start[1] + t/va_len*va[1]
-        z = start[2] + t/va_len*va[2]
-        */
-
-    //std::cout << " va.x = " << va.x << " va.y = " << va.y << " va.z = " << va.z << " vaLen = " << va_len << std::endl;
+// what the simulation needs to know about a loaded mesh
+Shape shapeOf(const MeshAsset &mesh) {
+  return Shape{mesh.boundsMin, mesh.boundsMax, mesh.width, mesh.height};
 }
 
-int main() {
-
-  float deltaTime = 0.0f; // Time between current frame and last frame
-  float lastFrame = 0.0f; // Time of last frame
+int main(int argc, char *argv[]) {
+  // --headless, --batch and --compare run the simulation without a window
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    return 1;
+  }
+  if (options.mode == Options::Mode::Headless) {
+    return runHeadless(options);
+  }
+  if (options.mode == Options::Mode::Batch) {
+    return runHeadlessBatch(options);
+  }
+  if (options.mode == Options::Mode::Compare) {
+    return runHeadlessCompare(options);
+  }
 
-  srand((unsigned int)time(NULL));
+  double deltaTime = 0.0; // Time between current frame and last frame
+  double lastFrame = 0.0; // Time of last frame
 
   if (!glfwInit()) {
     // Initialization failed
@@ -317,6 +245,7 @@ int main() {
   }
 
   glfwMakeContextCurrent(window);
+  glfwSwapInterval(vsync ? 1 : 0);
   glfwSetKeyCallback(window, key_callback);
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
@@ -343,22 +272,63 @@ int main() {
   // Cull triangles which normal is not towards the camera
   glEnable(GL_CULL_FACE);
 
-  GameObject pad;
-  pad.movement = glm::vec3(800.0f, 100.0f, 200.0f);
-  CreateGameObject(pad, "../pad.obj", "../pad.png");
-
-  GameObject ball;
-  ball.movement = glm::vec3(800.0f, 200.0f, 200.0f);
-  CreateGameObject(ball, "../ball.obj", "../ball.png");
+  AssetRegistry assets;
+  // --packed-vertices halves vertex memory, see vertexpacking.h
+  assets.setVertexFormat(options.packedVertices ? VertexFormat::Packed
+                                                : VertexFormat::Float);
+  assets.setVerbose(options.verbose);
+
+  // render ids of the objects, the game places them
+  GameObject pad, ball, block;
+  auto asset = [&options](const char *name) {
+    return (std::filesystem::path(options.assetDir) / name).string();
+  };
+  CreateGameObject(assets, pad, asset("pad.obj"), asset("pad.png"));
+  CreateGameObject(assets, ball, asset("ball.obj"), asset("ball.png"));
+  CreateGameObject(assets, block, asset("block.obj"), asset("ball.png"));
+
+  GameShapes shapes{shapeOf(assets.mesh(pad.meshId)),
+                    shapeOf(assets.mesh(ball.meshId)),
+                    shapeOf(assets.mesh(block.meshId))};
+  std::cout << " block width = " << shapes.block.width * block.scale.x
+            << std::endl;
+  Game game;
+  // every run launches the ball differently
+  game.setup(shapes, pad, ball, block, (uint64_t)time(NULL));
 
-  auto blocks = generateBlocks("../block.obj", "../ball.png");
+  BlockRenderer blockRenderer;
+  if (!game.blocks.empty()) {
+    blockRenderer.setup(assets, game.blocks, block.programId);
+  }
+  BallRenderer ballRenderer;
+  ballRenderer.setup(assets, game.ball);
+  // pad, every ball and every block get one model matrix a frame
+  RenderQueue renderQueue;
+  renderQueue.setup(game.blocks.size() + Game::maxBalls + 64);
 
   //  glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-  glm::vec3 padMov(0.0f, 0.0f, 0.0f);
-  glm::vec3 ballMov(1.0f, 1.0f, 0.0f);
+  FrameUniforms frameUniforms;
+  frameUniforms.setup();
+
+  float padDirection{0.0f};
+  // B launches ballBurst more balls, once per key press
+  constexpr uint32_t ballBurst = 1000;
+  bool spawnHeld{false};
+  // simulation and draw preparation, GL calls stay on this thread
+  JobSystem jobs;
+
+  // pad as of the previous tick, drawn blended with the current, the
+  // balls keep their own previous positions
+  FixedTimestep timestep(options.tickRate);
+  glm::vec3 previousPad = game.pad.movement;
+  lastFrame = glfwGetTime();
+
+  // --verbose prints what the render queue issued, averaged over a second
+  double statsStart = lastFrame;
+  uint64_t statsFrames{0}, statsDrawCalls{0}, statsStateChanges{0};
 
   while (!glfwWindowShouldClose(window)) {
-    float currentFrame = (float)glfwGetTime();
+    double currentFrame = glfwGetTime();
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
 
@@ -368,47 +338,94 @@ int main() {
     int lState = glfwGetKey(window, GLFW_KEY_LEFT);
 
     if (lState == GLFW_PRESS) {
-      padMov.x = -1.0f;
+      padDirection = -1.0f;
     } else if (rState == GLFW_PRESS) {
-      padMov.x = 1.0f;
+      padDirection = 1.0f;
     } else {
-      padMov.x = 0.0f;
+      padDirection = 0.0f;
     }
-
-    collision(ball.movement, ball.movement+ballMov * deltaTime * 40.0f);
-
-    pad.movement += padMov * deltaTime * 750.0f;
-    ball.movement += ballMov * deltaTime * 400.0f;
-
-    if (pad.movement.x < 0 + pad.mesh.width) {
-      pad.movement.x = pad.mesh.width;
-    }
-    if (pad.movement.x > SCREEN_WIDTH - pad.mesh.width) {
-      pad.movement.x = SCREEN_WIDTH - pad.mesh.width;
-    }
-
-    if (ball.movement.x > SCREEN_WIDTH - ball.mesh.width * deltaTime * 10.0f) {
-      ballMov.x = -ballMov.x;
-    }
-    if (ball.movement.x < ball.mesh.width) {
-      ballMov.x = -ballMov.x;
-    }
-    if (ball.movement.y > SCREEN_HEIGHT - ball.mesh.height) {
-      ballMov.y = -ballMov.y;
-    }
-    if (ball.movement.y < 0) {
-      ballMov.y = -ballMov.y;
+    bool spawnPressed = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+    if (spawnPressed && !spawnHeld) {
+      game.spawnBalls(ballBurst);
     }
+    spawnHeld = spawnPressed;
+
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    // camera and projection are shared by every draw of the frame
+    glm::mat4 view = camera();
+    // draws are sorted by program, texture and mesh before submission,
+    // waiting for the instance region has to happen on the GL thread
+    renderQueue.beginFrame(view, farPlane());
+
+    // Simulation, then the matrices and packets of everything it moved.
+    // Every job below is a child of frame, so waiting on it waits for all.
+    // The ticks of one game depend on each other and run in order, each
+    // spreads its balls over all threads once there are many.
+    uint32_t ticks = timestep.advance(deltaTime);
+    float alpha = timestep.alpha();
+    Job *frame = jobs.create(nullptr);
+    Job *simulate = jobs.create(
+        [&, ticks, alpha, frame] {
+          // the simulation always advances in steps of timestep.dt()
+          for (uint32_t tick = 0; tick < ticks; tick++) {
+            previousPad = game.pad.movement;
+            game.tick(padDirection, timestep.dt(), &jobs);
+          }
+
+          // the game is only read from here on
+          Job *blocks = jobs.create(
+              [&, alpha, frame] {
+                blockRenderer.update(game.blocks, game.destroyed(), jobs);
+                // blocks allocate first, so they keep their place in the
+                // instance ring and only dirty blocks are rewritten
+                blockRenderer.submit(renderQueue, jobs, frame);
+                jobs.run(jobs.create(
+                    [&, alpha, frame] {
+                      ballRenderer.submit(renderQueue, game.balls, alpha, jobs,
+                                          frame);
+                    },
+                    frame));
+                GameObject padView = game.pad;
+                padView.movement =
+                    glm::mix(previousPad, game.pad.movement, alpha);
+                jobs.run(jobs.create(
+                    [&, padView] { renderQueue.submit(assets, padView); },
+                    frame));
+              },
+              frame);
+          jobs.run(blocks);
+        },
+        frame);
+    jobs.run(simulate);
+    jobs.run(frame);
+
+    // GL work of the frame overlaps with the jobs
+    frameUniforms.update(view, projection(),
+                         glm::vec4(0.0f, 0.0f, framebufferWidth,
+                                   framebufferHeight),
+                         (float)currentFrame);
 
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT |
             GL_DEPTH_BUFFER_BIT); // also clear the depth buffer now!
 
-    renderObjs(pad);
-    renderObjs(ball);
-
-    for (auto &block : blocks) {
-      renderObjs(block);
+    jobs.wait(frame);
+    jobs.reset();
+    game.clearDestroyed();
+    renderQueue.flush(assets);
+    if (options.verbose) {
+      statsFrames++;
+      statsDrawCalls += renderQueue.drawCalls();
+      statsStateChanges += renderQueue.stateChanges();
+      if (currentFrame - statsStart >= 1.0) {
+        std::cout << statsFrames / (currentFrame - statsStart) << " fps, "
+                  << (double)statsDrawCalls / statsFrames << " draw calls, "
+                  << (double)statsStateChanges / statsFrames
+                  << " state changes a frame" << std::endl;
+        statsStart = currentFrame;
+        statsFrames = statsDrawCalls = statsStateChanges = 0;
+      }
     }
 
     glfwSwapBuffers(window);
@@ -416,13 +433,10 @@ int main() {
     glfwPollEvents();
   }
 
-  glDeleteVertexArrays(1, &pad.VAO);
-  glDeleteBuffers(1, &pad.VBO);
-  glDeleteBuffers(1, &pad.EBO);
-
-  glDeleteVertexArrays(1, &ball.VAO);
-  glDeleteBuffers(1, &ball.VBO);
-  glDeleteBuffers(1, &ball.EBO);
+  blockRenderer.release();
+  renderQueue.release();
+  frameUniforms.release();
+  assets.release();
 
   glfwDestroyWindow(window);
   glfwTerminate();
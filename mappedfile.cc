@@ -0,0 +1,86 @@
+#include "mappedfile.h"
+
+#include <filesystem>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &filename) {
+  m_open = map(filename) || read(filename);
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (m_mapped != nullptr) {
+    munmap(m_mapped, m_size);
+  }
+#endif
+}
+
+std::string_view MappedFile::data() const {
+  if (m_mapped != nullptr) {
+    return std::string_view(static_cast<const char *>(m_mapped), m_size);
+  }
+  return m_buffer;
+}
+
+bool MappedFile::map(const std::string &filename) {
+#ifndef _WIN32
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+
+  void *mapped =
+      mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping keeps its own reference to the file
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+  madvise(mapped, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+  m_mapped = mapped;
+  m_size = (size_t)info.st_size;
+  return true;
+#else
+  (void)filename;
+  return false;
+#endif
+}
+
+bool MappedFile::read(const std::string &filename) {
+  // a directory opens and seeks to the largest offset on some platforms
+  std::error_code error;
+  if (!std::filesystem::is_regular_file(filename, error)) {
+    return false;
+  }
+  std::ifstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file.seekg(0, std::ios::end);
+  std::streamoff size = file.tellg();
+  if (size < 0) { // a directory or a stream that cannot seek
+    return false;
+  }
+  m_buffer.resize((size_t)size);
+  file.seekg(0, std::ios::beg);
+  if (!file.read(m_buffer.data(), m_buffer.size())) {
+    m_buffer.clear();
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,32 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read only view of a whole file. The file is memory mapped when the
+// platform allows it, otherwise it is read into an owned buffer.
+class MappedFile {
+public:
+  MappedFile(const std::string &filename);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool isOpen() const { return m_open; }
+  bool isMapped() const { return m_mapped != nullptr; }
+  std::string_view data() const;
+
+private:
+  bool map(const std::string &filename);
+  bool read(const std::string &filename);
+
+  void *m_mapped{nullptr};
+  size_t m_size{0};
+  std::string m_buffer;
+  bool m_open{false};
+};
+
+#endif // MAPPEDFILE_H
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <vector>
 
@@ -9,11 +10,24 @@ struct Vertex {
   glm::vec2 TextureCoords;
 };
 
+// Compact 16 byte GPU layout of a Vertex, see vertexpacking.h
+struct PackedVertex {
+  uint16_t Coord[4];         // unorm16 inside the mesh bounds, w is padding
+  int16_t Normal[2];         // octahedral encoded, snorm16
+  uint16_t TextureCoords[2]; // half floats
+};
+
+enum class VertexFormat { Float, Packed };
+
 struct Mesh {
   std::vector<Vertex> vertices;
   std::vector<uint32_t> indicies;
+  // filled instead of indicies by compactIndicies() when every index fits
+  std::vector<uint16_t> shortIndicies;
   std::vector<uint32_t> texture_indicies;
   std::vector<uint32_t> normal_indicies;
+  glm::vec3 boundsMin{0.0f};
+  glm::vec3 boundsMax{0.0f};
   float width{0};
   float height{0};
 };
@@ -0,0 +1,124 @@
+#include "glad.h"
+
+#include "mesharena.h"
+
+#include <algorithm>
+
+namespace {
+// mesh vertices are read from this binding, instances from instanceBinding
+constexpr uint32_t vertexBinding = 0;
+// first allocation, the three models of the game fit in it
+constexpr size_t initialCapacity = 256 * 1024;
+} // namespace
+
+MeshArena::MeshArena() {}
+
+void MeshArena::setup(VertexFormat format, uint32_t indexSize) {
+  m_format = format;
+  m_indexSize = indexSize;
+  m_vertexSize =
+      format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+
+  glGenVertexArrays(1, &m_VAO);
+  glBindVertexArray(m_VAO);
+
+  if (format == VertexFormat::Packed) {
+    // vertex positions, normalized to the mesh bounds
+    glVertexAttribFormat(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0);
+    // octahedral vertex normals
+    glVertexAttribFormat(1, 2, GL_SHORT, GL_TRUE,
+                         offsetof(PackedVertex, Normal));
+    // vertex texture coords
+    glVertexAttribFormat(2, 2, GL_HALF_FLOAT, GL_FALSE,
+                         offsetof(PackedVertex, TextureCoords));
+  } else {
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal));
+    glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE,
+                         offsetof(Vertex, TextureCoords));
+  }
+  for (uint32_t attribute = 0; attribute < 3; attribute++) {
+    glEnableVertexAttribArray(attribute);
+    glVertexAttribBinding(attribute, vertexBinding);
+  }
+
+  // a mat4 attribute takes four vec4 slots
+  for (uint32_t column = 0; column < 4; column++) {
+    glEnableVertexAttribArray(instanceAttribute + column);
+    glVertexAttribFormat(instanceAttribute + column, 4, GL_FLOAT, GL_FALSE,
+                         column * sizeof(glm::vec4));
+    glVertexAttribBinding(instanceAttribute + column, instanceBinding);
+  }
+  glVertexBindingDivisor(instanceBinding, 1);
+
+  glBindVertexArray(0);
+}
+
+void MeshArena::append(const void *vertices, uint32_t vertexCount,
+                       const void *indicies, uint32_t indexCount,
+                       int32_t &baseVertex, uint32_t &firstIndex) {
+  size_t vertexBytes = (size_t)vertexCount * m_vertexSize;
+  size_t indexBytes = (size_t)indexCount * m_indexSize;
+  size_t vertexUsed = (size_t)m_vertexCount * m_vertexSize;
+  size_t indexUsed = (size_t)m_indexCount * m_indexSize;
+
+  glBindVertexArray(m_VAO);
+  if (vertexUsed + vertexBytes > m_vertexCapacity) {
+    m_VBO = grow(m_VBO, vertexUsed, m_vertexCapacity,
+                 vertexUsed + vertexBytes);
+    glBindVertexBuffer(vertexBinding, m_VBO, 0, m_vertexSize);
+  }
+  if (indexUsed + indexBytes > m_indexCapacity) {
+    m_EBO = grow(m_EBO, indexUsed, m_indexCapacity, indexUsed + indexBytes);
+    // the element buffer binding is VAO state
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+  }
+  glBindVertexArray(0);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  glBufferSubData(GL_ARRAY_BUFFER, vertexUsed, vertexBytes, vertices);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, m_EBO);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, indexUsed, indexBytes, indicies);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // mesh indices stay local, baseVertex moves them to the mesh's vertices
+  baseVertex = m_vertexCount;
+  firstIndex = m_indexCount;
+  m_vertexCount += vertexCount;
+  m_indexCount += indexCount;
+}
+
+void MeshArena::release() {
+  glDeleteVertexArrays(1, &m_VAO);
+  glDeleteBuffers(1, &m_VBO);
+  glDeleteBuffers(1, &m_EBO);
+  m_VAO = m_VBO = m_EBO = 0;
+  m_vertexCount = m_indexCount = 0;
+  m_vertexCapacity = m_indexCapacity = 0;
+}
+
+// Replaces buffer with one of at least needed bytes, keeping the first used
+// bytes of the old one.
+uint32_t MeshArena::grow(uint32_t buffer, size_t used, size_t &capacity,
+                         size_t needed) {
+  size_t newCapacity = std::max(capacity, initialCapacity);
+  while (newCapacity < needed) {
+    newCapacity *= 2;
+  }
+
+  uint32_t newBuffer;
+  glGenBuffers(1, &newBuffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+  glBufferData(GL_COPY_WRITE_BUFFER, newCapacity, nullptr, GL_STATIC_DRAW);
+  if (used > 0) {
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  glDeleteBuffers(1, &buffer);
+
+  capacity = newCapacity;
+  return newBuffer;
+}
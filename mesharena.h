@@ -0,0 +1,47 @@
+#ifndef MESHARENA_H
+#define MESHARENA_H
+
+#include "mesh.h"
+#include <cstddef>
+#include <cstdint>
+
+// Every arena VAO reads a per instance model matrix from this vertex buffer
+// binding into attribute locations 3-6, the buffer is bound at draw time.
+constexpr uint32_t instanceAttribute = 3;
+constexpr uint32_t instanceBinding = 3;
+
+// One VAO over a shared vertex and index buffer that meshes of the same
+// vertex format and index size are appended to. Meshes are addressed by
+// firstIndex and baseVertex, so any number of them can be drawn from one
+// glMultiDrawElementsIndirect call. The buffers grow by doubling.
+class MeshArena {
+public:
+  MeshArena();
+
+  void setup(VertexFormat format, uint32_t indexSize);
+  // vertices are Vertex or PackedVertex depending on the arena format
+  void append(const void *vertices, uint32_t vertexCount,
+              const void *indicies, uint32_t indexCount, int32_t &baseVertex,
+              uint32_t &firstIndex);
+  void release();
+
+  VertexFormat format() const { return m_format; }
+  uint32_t indexSize() const { return m_indexSize; }
+  uint32_t VAO() const { return m_VAO; }
+
+private:
+  uint32_t grow(uint32_t buffer, size_t used, size_t &capacity, size_t needed);
+
+  VertexFormat m_format{VertexFormat::Float};
+  uint32_t m_vertexSize{0};
+  uint32_t m_indexSize{0};
+  uint32_t m_VAO{0};
+  uint32_t m_VBO{0};
+  uint32_t m_EBO{0};
+  uint32_t m_vertexCount{0};
+  uint32_t m_indexCount{0};
+  size_t m_vertexCapacity{0}; // bytes
+  size_t m_indexCapacity{0};  // bytes
+};
+
+#endif // MESHARENA_H
@@ -0,0 +1,125 @@
+#include "meshcache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+constexpr char meshCacheMagic[4] = {'B', 'O', 'M', 'C'};
+// bump whenever MeshCacheHeader or Vertex changes layout
+constexpr uint32_t meshCacheVersion = 3;
+
+static_assert(sizeof(MeshCacheHeader) % alignof(Vertex) == 0,
+              "vertex data must stay aligned after the header");
+} // namespace
+
+MeshCacheFile::MeshCacheFile(const std::string &filename) : m_file(filename) {
+  if (!m_file.isOpen()) {
+    return;
+  }
+
+  auto data = m_file.data();
+  if (data.size() < sizeof(MeshCacheHeader)) {
+    return;
+  }
+
+  auto header = reinterpret_cast<const MeshCacheHeader *>(data.data());
+  if (std::memcmp(header->magic, meshCacheMagic, sizeof(meshCacheMagic)) != 0 ||
+      header->version != meshCacheVersion ||
+      (header->indexSize != sizeof(uint16_t) &&
+       header->indexSize != sizeof(uint32_t))) {
+    return;
+  }
+
+  size_t expected = sizeof(MeshCacheHeader) +
+                    header->vertexCount * sizeof(Vertex) +
+                    (size_t)header->indexCount * header->indexSize;
+  if (data.size() != expected) {
+    return;
+  }
+
+  m_header = header;
+}
+
+const Vertex *MeshCacheFile::vertices() const {
+  return reinterpret_cast<const Vertex *>(m_file.data().data() +
+                                          sizeof(MeshCacheHeader));
+}
+
+const void *MeshCacheFile::indicies() const {
+  return m_file.data().data() + sizeof(MeshCacheHeader) +
+         m_header->vertexCount * sizeof(Vertex);
+}
+
+std::string meshCacheName(const std::string &objFilename) {
+  return std::filesystem::path(objFilename).replace_extension(".mesh").string();
+}
+
+bool meshCacheIsFresh(const std::string &objFilename,
+                      const std::string &cacheFilename) {
+  std::error_code error;
+  auto cacheTime = std::filesystem::last_write_time(cacheFilename, error);
+  if (error) {
+    return false;
+  }
+  auto objTime = std::filesystem::last_write_time(objFilename, error);
+  if (error) {
+    return true; // only the compiled mesh shipped
+  }
+
+  return cacheTime >= objTime;
+}
+
+bool writeMeshCache(const std::string &cacheFilename, const Mesh &mesh,
+                    uint32_t flags) {
+  MeshCacheHeader header;
+  std::memcpy(header.magic, meshCacheMagic, sizeof(meshCacheMagic));
+  header.version = meshCacheVersion;
+  header.flags = flags;
+  header.vertexCount = mesh.vertices.size();
+  bool shortIndicies = mesh.indicies.empty() && !mesh.shortIndicies.empty();
+  header.indexCount =
+      shortIndicies ? mesh.shortIndicies.size() : mesh.indicies.size();
+  header.indexSize = shortIndicies ? sizeof(uint16_t) : sizeof(uint32_t);
+  header.boundsMin = mesh.boundsMin;
+  header.boundsMax = mesh.boundsMax;
+  header.width = mesh.width;
+  header.height = mesh.height;
+
+  // written under a temporary name so a crash never leaves a torn cache
+  std::string tempFilename = cacheFilename + ".tmp";
+  std::error_code error;
+  {
+    std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      std::cout << "Unable to write mesh cache " << cacheFilename << std::endl;
+      std::filesystem::remove(tempFilename, error);
+      return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(mesh.vertices.data()),
+               mesh.vertices.size() * sizeof(Vertex));
+    if (shortIndicies) {
+      file.write(reinterpret_cast<const char *>(mesh.shortIndicies.data()),
+                 mesh.shortIndicies.size() * sizeof(uint16_t));
+    } else {
+      file.write(reinterpret_cast<const char *>(mesh.indicies.data()),
+                 mesh.indicies.size() * sizeof(uint32_t));
+    }
+    file.close();
+    if (!file) {
+      std::cout << "Unable to write mesh cache " << cacheFilename << std::endl;
+      std::filesystem::remove(tempFilename, error);
+      return false;
+    }
+  }
+
+  std::filesystem::rename(tempFilename, cacheFilename, error);
+  if (error) {
+    std::cout << "Unable to write mesh cache " << cacheFilename << std::endl;
+    std::filesystem::remove(tempFilename, error);
+    return false;
+  }
+  return true;
+}
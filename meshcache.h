@@ -0,0 +1,49 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include "mappedfile.h"
+#include "mesh.h"
+#include <cstdint>
+#include <string>
+
+// Compiled mesh file written next to the .obj it was parsed from:
+// header, interleaved Vertex array and index array (uint16_t or uint32_t,
+// see indexSize), ready to be handed to glBufferData as is.
+struct MeshCacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t flags;
+  uint32_t vertexCount;
+  uint32_t indexCount;
+  uint32_t indexSize; // bytes per index, 2 or 4
+  glm::vec3 boundsMin;
+  glm::vec3 boundsMax;
+  float width;
+  float height;
+};
+
+enum MeshCacheFlags : uint32_t {
+  MeshCacheOptimized = 1, // triangles and vertices went through optimizeMesh
+};
+
+class MeshCacheFile {
+public:
+  MeshCacheFile(const std::string &filename);
+
+  bool isValid() const { return m_header != nullptr; }
+  const MeshCacheHeader &header() const { return *m_header; }
+  const Vertex *vertices() const;
+  const void *indicies() const;
+
+private:
+  MappedFile m_file;
+  const MeshCacheHeader *m_header{nullptr};
+};
+
+std::string meshCacheName(const std::string &objFilename);
+bool meshCacheIsFresh(const std::string &objFilename,
+                      const std::string &cacheFilename);
+bool writeMeshCache(const std::string &cacheFilename, const Mesh &mesh,
+                    uint32_t flags);
+
+#endif // MESHCACHE_H
@@ -0,0 +1,323 @@
+#include "meshoptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+constexpr int forsythCacheSize = 32;
+constexpr float forsythLastTriScore = 0.75f;
+constexpr float forsythCacheDecay = 1.5f;
+constexpr float forsythValenceScale = 2.0f;
+constexpr float forsythValencePower = 0.5f;
+
+float vertexScore(int cachePosition, uint32_t remainingTris) {
+  if (remainingTris == 0) {
+    return -1.0f; // no triangle needs this vertex any more
+  }
+
+  float score{0.0f};
+  if (cachePosition >= 0) {
+    if (cachePosition < 3) {
+      // used by the last triangle, fixed score so it is not preferred over
+      // vertices a bit further back in the cache
+      score = forsythLastTriScore;
+    } else {
+      float scaler = 1.0f / (forsythCacheSize - 3);
+      score = std::pow(1.0f - (cachePosition - 3) * scaler, forsythCacheDecay);
+    }
+  }
+  // vertices with few triangles left get a boost to finish them off
+  score += forsythValenceScale *
+           std::pow((float)remainingTris, -forsythValencePower);
+  return score;
+}
+
+// Applies a new triangle order to the index buffer and, when they are per
+// corner, the file texture and normal indices.
+void reorderTriangles(Mesh &mesh, const std::vector<uint32_t> &triOrder) {
+  auto permute = [&triOrder](std::vector<uint32_t> &corners) {
+    std::vector<uint32_t> result(corners.size());
+    for (size_t n = 0; n < triOrder.size(); n++) {
+      for (size_t c = 0; c < 3; c++) {
+        result[n * 3 + c] = corners[triOrder[n] * 3 + c];
+      }
+    }
+    corners.swap(result);
+  };
+
+  size_t cornerCount = mesh.indicies.size();
+  permute(mesh.indicies);
+  if (mesh.texture_indicies.size() == cornerCount) {
+    permute(mesh.texture_indicies);
+  }
+  if (mesh.normal_indicies.size() == cornerCount) {
+    permute(mesh.normal_indicies);
+  }
+}
+} // namespace
+
+VertexCacheStats analyzeVertexCache(const Mesh &mesh, uint32_t cacheSize) {
+  VertexCacheStats stats;
+  if (mesh.indicies.empty() || mesh.vertices.empty()) {
+    return stats;
+  }
+
+  // FIFO cache: a vertex is resident while it was inserted less than
+  // cacheSize misses ago
+  std::vector<uint32_t> insertedAt(mesh.vertices.size(), 0);
+  std::vector<bool> used(mesh.vertices.size(), false);
+  uint32_t uniqueVertices{0};
+
+  for (auto index : mesh.indicies) {
+    if (!used[index]) {
+      used[index] = true;
+      uniqueVertices++;
+    } else if (stats.misses - insertedAt[index] < cacheSize) {
+      continue;
+    }
+    stats.misses++;
+    insertedAt[index] = stats.misses;
+  }
+
+  stats.acmr = (float)stats.misses / (mesh.indicies.size() / 3);
+  stats.atvr = (float)stats.misses / uniqueVertices;
+  return stats;
+}
+
+void optimizeVertexCache(Mesh &mesh) {
+  size_t triCount = mesh.indicies.size() / 3;
+  size_t vertexCount = mesh.vertices.size();
+  if (triCount < 2) {
+    return;
+  }
+  const auto &indicies = mesh.indicies;
+
+  // triangles using each vertex, packed into one array
+  std::vector<uint32_t> remaining(vertexCount, 0);
+  for (size_t n = 0; n < triCount * 3; n++) {
+    remaining[indicies[n]]++;
+  }
+  std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+  std::partial_sum(remaining.begin(), remaining.end(),
+                   adjacencyStart.begin() + 1);
+  std::vector<uint32_t> adjacency(triCount * 3);
+  {
+    std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t n = 0; n < triCount * 3; n++) {
+      adjacency[fill[indicies[n]]++] = n / 3;
+    }
+  }
+
+  std::vector<int> cachePosition(vertexCount, -1);
+  std::vector<float> score(vertexCount);
+  for (size_t v = 0; v < vertexCount; v++) {
+    score[v] = vertexScore(-1, remaining[v]);
+  }
+  std::vector<float> triScore(triCount);
+  for (size_t t = 0; t < triCount; t++) {
+    triScore[t] = score[indicies[t * 3]] + score[indicies[t * 3 + 1]] +
+                  score[indicies[t * 3 + 2]];
+  }
+
+  std::vector<bool> emitted(triCount, false);
+  std::vector<uint32_t> triOrder;
+  triOrder.reserve(triCount);
+  // the cache holds three extra entries for the triangle being added
+  std::vector<uint32_t> cache, nextCache;
+  cache.reserve(forsythCacheSize + 3);
+  nextCache.reserve(forsythCacheSize + 3);
+
+  int64_t best = std::max_element(triScore.begin(), triScore.end()) -
+                 triScore.begin();
+  size_t scanCursor{0};
+
+  while (best >= 0) {
+    emitted[best] = true;
+    triOrder.push_back(best);
+
+    // push the triangle to the front of the LRU cache
+    nextCache.clear();
+    for (size_t c = 0; c < 3; c++) {
+      uint32_t vertex = indicies[best * 3 + c];
+      nextCache.push_back(vertex);
+
+      // drop the triangle from the vertex adjacency
+      auto begin = adjacency.begin() + adjacencyStart[vertex];
+      auto end = begin + remaining[vertex];
+      std::iter_swap(std::find(begin, end, (uint32_t)best), end - 1);
+      remaining[vertex]--;
+    }
+    for (auto vertex : cache) {
+      if (vertex != nextCache[0] && vertex != nextCache[1] &&
+          vertex != nextCache[2]) {
+        nextCache.push_back(vertex);
+      }
+    }
+    // evicted vertices lose their cache score
+    for (size_t n = forsythCacheSize; n < nextCache.size(); n++) {
+      cachePosition[nextCache[n]] = -1;
+      score[nextCache[n]] = vertexScore(-1, remaining[nextCache[n]]);
+    }
+    nextCache.resize(std::min<size_t>(nextCache.size(), forsythCacheSize));
+    cache.swap(nextCache);
+
+    for (size_t n = 0; n < cache.size(); n++) {
+      cachePosition[cache[n]] = n;
+      score[cache[n]] = vertexScore(n, remaining[cache[n]]);
+    }
+
+    // only triangles touching the cache changed score
+    best = -1;
+    float bestScore{-1.0f};
+    for (auto vertex : cache) {
+      auto begin = adjacencyStart[vertex];
+      for (uint32_t a = begin; a < begin + remaining[vertex]; a++) {
+        uint32_t tri = adjacency[a];
+        float s = score[indicies[tri * 3]] + score[indicies[tri * 3 + 1]] +
+                  score[indicies[tri * 3 + 2]];
+        triScore[tri] = s;
+        if (s > bestScore) {
+          bestScore = s;
+          best = tri;
+        }
+      }
+    }
+
+    if (best < 0) {
+      // nothing adjacent left, continue with the next unused triangle
+      while (scanCursor < triCount && emitted[scanCursor]) {
+        scanCursor++;
+      }
+      best = scanCursor < triCount ? (int64_t)scanCursor : -1;
+    }
+  }
+
+  reorderTriangles(mesh, triOrder);
+}
+
+void optimizeOverdraw(Mesh &mesh, float threshold) {
+  size_t triCount = mesh.indicies.size() / 3;
+  if (triCount < 2) {
+    return;
+  }
+  const auto &indicies = mesh.indicies;
+  const auto &vertices = mesh.vertices;
+
+  // a new cluster starts where the cache order jumps, i.e. a triangle with
+  // all three vertices missing a 16 entry FIFO cache
+  std::vector<uint32_t> clusterStart;
+  {
+    std::vector<uint32_t> insertedAt(vertices.size(), 0);
+    std::vector<bool> used(vertices.size(), false);
+    uint32_t misses{0};
+    for (size_t t = 0; t < triCount; t++) {
+      uint32_t triMisses{0};
+      for (size_t c = 0; c < 3; c++) {
+        uint32_t index = indicies[t * 3 + c];
+        if (!used[index] || misses - insertedAt[index] >= 16) {
+          used[index] = true;
+          misses++;
+          triMisses++;
+          insertedAt[index] = misses;
+        }
+      }
+      if (t == 0 || triMisses == 3) {
+        clusterStart.push_back(t);
+      }
+    }
+  }
+  if (clusterStart.size() < 2) {
+    return;
+  }
+  clusterStart.push_back(triCount);
+
+  glm::vec3 meshCentroid{0.0f};
+  for (const auto &vertex : vertices) {
+    meshCentroid += vertex.Coord;
+  }
+  meshCentroid = meshCentroid / (float)vertices.size();
+
+  // clusters facing away from the centre are likely in front, draw those
+  // first so the depth test rejects what they cover
+  size_t clusterCount = clusterStart.size() - 1;
+  std::vector<float> sortKey(clusterCount);
+  for (size_t n = 0; n < clusterCount; n++) {
+    glm::vec3 centroid{0.0f}, normal{0.0f};
+    float area{0.0f};
+    for (uint32_t t = clusterStart[n]; t < clusterStart[n + 1]; t++) {
+      const auto &a = vertices[indicies[t * 3]].Coord;
+      const auto &b = vertices[indicies[t * 3 + 1]].Coord;
+      const auto &c = vertices[indicies[t * 3 + 2]].Coord;
+      glm::vec3 faceNormal = glm::cross(b - a, c - a);
+      float faceArea = glm::length(faceNormal);
+      centroid += (a + b + c) * (faceArea / 3.0f);
+      normal += faceNormal;
+      area += faceArea;
+    }
+    if (area > 0.0f) {
+      centroid = centroid / area;
+    }
+    float normalLength = glm::length(normal);
+    if (normalLength > 0.0f) {
+      normal = normal / normalLength;
+    }
+    sortKey[n] = glm::dot(centroid - meshCentroid, normal);
+  }
+
+  std::vector<uint32_t> clusterOrder(clusterCount);
+  std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+  std::stable_sort(
+      clusterOrder.begin(), clusterOrder.end(),
+      [&sortKey](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+  std::vector<uint32_t> triOrder;
+  triOrder.reserve(triCount);
+  for (auto cluster : clusterOrder) {
+    for (uint32_t t = clusterStart[cluster]; t < clusterStart[cluster + 1];
+         t++) {
+      triOrder.push_back(t);
+    }
+  }
+
+  Mesh reordered = mesh;
+  reorderTriangles(reordered, triOrder);
+  if (analyzeVertexCache(reordered).acmr <=
+      analyzeVertexCache(mesh).acmr * threshold) {
+    mesh = std::move(reordered);
+  }
+}
+
+void optimizeVertexFetch(Mesh &mesh) {
+  constexpr uint32_t unused = 0xffffffff;
+  std::vector<uint32_t> remap(mesh.vertices.size(), unused);
+  std::vector<Vertex> vertices;
+  vertices.reserve(mesh.vertices.size());
+
+  for (auto &index : mesh.indicies) {
+    if (remap[index] == unused) {
+      remap[index] = vertices.size();
+      vertices.push_back(mesh.vertices[index]);
+    }
+    index = remap[index];
+  }
+  // vertices no face refers to are dropped
+  mesh.vertices.swap(vertices);
+}
+
+void optimizeMesh(Mesh &mesh) {
+  optimizeVertexCache(mesh);
+  optimizeOverdraw(mesh);
+  optimizeVertexFetch(mesh);
+}
+
+bool compactIndicies(Mesh &mesh) {
+  if (mesh.vertices.size() > 65536 || mesh.indicies.empty()) {
+    return false;
+  }
+
+  mesh.shortIndicies.assign(mesh.indicies.begin(), mesh.indicies.end());
+  mesh.indicies.clear();
+  mesh.indicies.shrink_to_fit();
+  return true;
+}
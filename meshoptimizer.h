@@ -0,0 +1,36 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include "mesh.h"
+#include <cstdint>
+
+// Post-transform vertex cache efficiency of an index buffer simulated with
+// a FIFO cache. acmr is cache misses per triangle (0.5 is ideal for big
+// grids, 3 is worst), atvr is cache misses per vertex (1 is ideal).
+struct VertexCacheStats {
+  uint32_t misses{0};
+  float acmr{0};
+  float atvr{0};
+};
+
+VertexCacheStats analyzeVertexCache(const Mesh &mesh, uint32_t cacheSize = 16);
+
+// Reorders triangles for vertex cache locality (Forsyth's linear-speed
+// algorithm).
+void optimizeVertexCache(Mesh &mesh);
+// Groups the cache optimized triangles into clusters and draws clusters
+// facing out of the mesh first to cut overdraw. The new order is only kept
+// when its ACMR stays within `threshold` of the input.
+void optimizeOverdraw(Mesh &mesh, float threshold = 1.05f);
+// Reorders vertices by first use in the index buffer and remaps indices.
+void optimizeVertexFetch(Mesh &mesh);
+
+// runs all of the above in the right order
+void optimizeMesh(Mesh &mesh);
+
+// Moves indicies into shortIndicies when the mesh has at most 65536
+// vertices, returns true when it did. Run after the passes above, they all
+// work on 32 bit indices.
+bool compactIndicies(Mesh &mesh);
+
+#endif // MESHOPTIMIZER_H
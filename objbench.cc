@@ -0,0 +1,212 @@
+// Times WaveFrontReader on ball.obj and on a generated grid mesh against
+// the stringstream reader it replaced, single threaded and on a ThreadPool.
+// Exits with 1 when any of them parses a file differently.
+//   objbench [model.obj] [grid size]
+// Run it from the build directory like the game, so ../ball.obj is found.
+
+#include "threadpool.h"
+#include "wavefrontreader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+namespace {
+constexpr int repeats = 5;
+
+// size x size quads, every vertex with its own uv and normal
+void writeGrid(const std::string &filename, uint32_t size) {
+  std::ofstream file(filename, std::ios::binary);
+  for (uint32_t y = 0; y <= size; y++) {
+    for (uint32_t x = 0; x <= size; x++) {
+      file << "v " << x * 0.01f << ' ' << y * 0.01f << ' '
+           << ((x * 7 + y * 13) % 17) * 0.001f << '\n';
+      file << "vt " << (float)x / size << ' ' << (float)y / size << '\n';
+      file << "vn 0 0 1\n";
+    }
+  }
+  for (uint32_t y = 0; y < size; y++) {
+    for (uint32_t x = 0; x < size; x++) {
+      uint32_t a = y * (size + 1) + x + 1;
+      uint32_t b = a + 1;
+      uint32_t c = a + size + 1;
+      uint32_t d = c + 1;
+      file << "f " << a << '/' << a << '/' << a << ' ' << b << '/' << b << '/'
+           << b << ' ' << d << '/' << d << '/' << d << '\n';
+      file << "f " << a << '/' << a << '/' << a << ' ' << d << '/' << d << '/'
+           << d << ' ' << c << '/' << c << '/' << c << '\n';
+    }
+  }
+}
+
+// face corner key of readLegacy
+struct Corner {
+  uint64_t v, vt, vn;
+  bool operator==(const Corner &other) const {
+    return v == other.v && vt == other.vt && vn == other.vn;
+  }
+};
+
+struct CornerHash {
+  size_t operator()(const Corner &corner) const {
+    return (corner.v * 0x9e3779b97f4a7c15ull) ^
+           (corner.vt * 0xc2b2ae3d27d4eb4full) ^
+           (corner.vn * 0x165667b19e3779f9ull);
+  }
+};
+
+// WaveFrontReader::readVertices as it was before parsing in place, a
+// stringstream per line. Corners are keyed on the whole (v, vt, vn) triple
+// like the current reader, the old v | vt << 16 key merged corners with
+// different normals and collided past 65535 vertices, so both readers give
+// the same mesh and the times compare the parsing alone.
+void readLegacy(const std::string &filename, Mesh &obj) {
+  std::ifstream myfile(filename);
+  std::string line;
+  uint32_t vertexIndex{0};
+  std::vector<glm::vec3> vertices;
+  std::vector<glm::vec2> textureCoords;
+  std::vector<glm::vec3> normals;
+  std::unordered_map<Corner, uint32_t, CornerHash> faces;
+
+  while (getline(myfile, line)) {
+    if (line.find("v ") == 0) {
+      std::stringstream conv{line.substr(1)};
+      float x, y, z;
+      conv >> x >> y >> z;
+      vertices.push_back(glm::vec3(x, y, z));
+      continue;
+    }
+    if (line.find("vt ") == 0) {
+      std::stringstream conv{line.substr(2)};
+      float x, y;
+      conv >> x >> y;
+      textureCoords.push_back(glm::vec2(x, -y));
+      continue;
+    }
+    if (line.find("vn ") == 0) {
+      std::stringstream conv{line.substr(2)};
+      float x, y, z;
+      conv >> x >> y >> z;
+      normals.push_back(glm::vec3(x, y, z));
+      continue;
+    }
+    if (line.find("f ") == 0) {
+      std::istringstream splitter{line.substr(2)};
+      std::string face;
+      while (std::getline(splitter, face, ' ')) {
+        Vertex vert{};
+        Corner corner{0, 0, 0};
+        auto start_pos = face.find('/');
+        corner.v = std::stoul(face.substr(0, start_pos), nullptr);
+        vert.Coord = vertices[corner.v - 1];
+        auto end_pos = face.find('/', start_pos + 1);
+        if (start_pos != end_pos - 1) {
+          corner.vt = std::stoul(
+              face.substr(start_pos + 1, end_pos - (start_pos + 1)), nullptr);
+          obj.texture_indicies.push_back((uint32_t)corner.vt - 1);
+          vert.TextureCoords = textureCoords[corner.vt - 1];
+        }
+        if (end_pos != std::string::npos) {
+          corner.vn = std::stoul(face.substr(end_pos + 1), nullptr);
+          obj.normal_indicies.push_back((uint32_t)corner.vn - 1);
+          vert.Normal = normals[corner.vn - 1];
+        }
+        auto [found, inserted] = faces.try_emplace(corner, vertexIndex);
+        obj.indicies.push_back(found->second);
+        if (inserted) {
+          obj.vertices.push_back(vert);
+          vertexIndex++;
+        }
+      }
+    }
+  }
+}
+
+// best of repeats, in milliseconds
+template <typename Read> double bestTime(Read read, Mesh &mesh) {
+  double best{1e30};
+  for (int n = 0; n < repeats; n++) {
+    mesh = Mesh();
+    auto start = std::chrono::steady_clock::now();
+    read(mesh);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+bool sameMesh(const Mesh &a, const Mesh &b) {
+  return a.indicies == b.indicies && a.vertices.size() == b.vertices.size() &&
+         std::equal(a.vertices.begin(), a.vertices.end(), b.vertices.begin(),
+                    [](const Vertex &left, const Vertex &right) {
+                      return left.Coord == right.Coord &&
+                             left.Normal == right.Normal &&
+                             left.TextureCoords == right.TextureCoords;
+                    });
+}
+
+bool report(const std::string &filename, ThreadPool &pool) {
+  WaveFrontReader reader(filename);
+  Mesh legacy, single, parallel;
+  double legacyTime =
+      bestTime([&](Mesh &mesh) { readLegacy(filename, mesh); }, legacy);
+  double singleTime = bestTime([&](Mesh &mesh) { reader.readVertices(mesh); },
+                               single);
+  double parallelTime = bestTime(
+      [&](Mesh &mesh) { reader.readVertices(mesh, pool); }, parallel);
+
+  auto bytes = std::filesystem::file_size(filename);
+  std::cout << filename << ": " << bytes / 1048576.0 << " MiB, "
+            << single.vertices.size() << " vertices, "
+            << single.indicies.size() / 3 << " triangles" << std::endl;
+  auto print = [bytes, legacyTime](const std::string &name, double time) {
+    std::cout << "  " << name << time << " ms, "
+              << bytes / 1048576.0 / (time / 1000.0) << " MiB/s, "
+              << legacyTime / time << "x" << std::endl;
+  };
+  print("stringstream  ", legacyTime);
+  print("1 thread      ", singleTime);
+  print("pool of " + std::to_string(pool.size()) + "     ", parallelTime);
+
+  if (single.vertices.empty() || !sameMesh(legacy, single)) {
+    std::cerr << "Error " << filename
+              << " parsed differently than by the stringstream reader"
+              << std::endl;
+    return false;
+  }
+  if (!sameMesh(single, parallel)) {
+    std::cerr << "Error " << filename
+              << " parsed differently on the thread pool" << std::endl;
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string model = argc > 1 ? argv[1] : "../ball.obj";
+  uint32_t gridSize = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+
+  ThreadPool pool;
+  if (!std::filesystem::exists(model)) {
+    std::cerr << "Error could not find " << model << std::endl;
+    return 1;
+  }
+  bool ok = report(model, pool);
+
+  auto grid = (std::filesystem::temp_directory_path() / "objbench_grid.obj")
+                  .string();
+  writeGrid(grid, std::max<uint32_t>(gridSize, 1));
+  ok = report(grid, pool) && ok;
+  std::filesystem::remove(grid);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#include "options.h"
+
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace {
+// argv[arg] as a count above 0 and at most max
+bool readCount(int argc, char *argv[], int arg, uint64_t &count,
+               uint64_t max = std::numeric_limits<uint64_t>::max()) {
+  if (arg >= argc) {
+    return false;
+  }
+  const char *end = argv[arg] + std::strlen(argv[arg]);
+  auto [last, error] = std::from_chars(argv[arg], end, count);
+  return error == std::errc() && last == end && count > 0 && count <= max;
+}
+
+// argv[arg] as ticks per second, slower than 1 or faster than 10000 would
+// stall the game or drown it in ticks
+bool readRate(int argc, char *argv[], int arg, double &rate) {
+  if (arg >= argc) {
+    return false;
+  }
+  const char *end = argv[arg] + std::strlen(argv[arg]);
+  auto [last, error] = std::from_chars(argv[arg], end, rate);
+  return error == std::errc() && last == end && rate >= 1.0 && rate <= 10000.0;
+}
+
+bool usage(const char *program, const std::string &problem) {
+  std::cerr << "Error " << problem << std::endl
+            << "usage: " << program << " [options]" << std::endl
+            << "  --headless TICKS [BALLS]  run TICKS ticks without a window"
+            << std::endl
+            << "  --batch GAMES TICKS       run TICKS ticks of GAMES games"
+            << std::endl
+            << "  --compare GAMES TICKS     check the batch against Game"
+            << std::endl
+            << "  --tick-rate HZ            simulation ticks per second"
+            << std::endl
+            << "  --assets DIR              read models and textures from DIR"
+            << std::endl
+            << "  --packed-vertices         upload quantized vertices"
+            << std::endl
+            << "  --verbose                 print mesh and draw statistics"
+            << std::endl;
+  return false;
+}
+} // namespace
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+  for (int arg = 1; arg < argc; arg++) {
+    std::string_view name = argv[arg];
+    uint64_t first{0}, second{0};
+    if (name == "--headless") {
+      if (!readCount(argc, argv, arg + 1, first)) {
+        return usage(argv[0], "--headless needs a tick count");
+      }
+      options.mode = Options::Mode::Headless;
+      options.ticks = first;
+      arg++;
+      // the ball count is optional, anything but another option is one
+      if (arg + 1 < argc && argv[arg + 1][0] != '-') {
+        if (!readCount(argc, argv, arg + 1, second,
+                       std::numeric_limits<uint32_t>::max())) {
+          return usage(argv[0], "bad ball count " + std::string(argv[arg + 1]));
+        }
+        options.balls = (uint32_t)second;
+        arg++;
+      }
+    } else if (name == "--batch" || name == "--compare") {
+      if (!readCount(argc, argv, arg + 1, first) ||
+          !readCount(argc, argv, arg + 2, second)) {
+        return usage(argv[0],
+                     std::string(name) + " needs a game and a tick count");
+      }
+      options.mode = name == "--batch" ? Options::Mode::Batch
+                                       : Options::Mode::Compare;
+      options.games = first;
+      options.ticks = second;
+      arg += 2;
+    } else if (name == "--tick-rate") {
+      if (!readRate(argc, argv, arg + 1, options.tickRate)) {
+        return usage(argv[0], "--tick-rate needs a rate from 1 to 10000");
+      }
+      arg++;
+    } else if (name == "--assets") {
+      if (arg + 1 >= argc) {
+        return usage(argv[0], "--assets needs a directory");
+      }
+      options.assetDir = argv[++arg];
+    } else if (name == "--packed-vertices") {
+      options.packedVertices = true;
+    } else if (name == "--verbose") {
+      options.verbose = true;
+    } else {
+      return usage(argv[0], "unknown option " + std::string(name));
+    }
+  }
+  return true;
+}
@@ -0,0 +1,39 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "game.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Command line shared by breakout and breakout_headless.
+//   --headless TICKS [BALLS]  runs TICKS simulation ticks without a window,
+//                             the pad following the first of BALLS balls
+//   --batch GAMES TICKS       runs TICKS ticks of GAMES games at once
+//   --compare GAMES TICKS     runs the batch games one by one as well and
+//                             fails when any of them differs
+//   --tick-rate HZ            simulation ticks per second, 120 by default
+//   --assets DIR              reads the models and textures from DIR, the
+//                             parent of the build directory by default
+//   --packed-vertices         uploads meshes as 16 byte PackedVertex
+//   --verbose                 prints mesh diagnostics while loading and
+//                             draw statistics every second
+struct Options {
+  enum class Mode { Window, Headless, Batch, Compare };
+
+  Mode mode{Mode::Window};
+  uint64_t ticks{0};
+  uint32_t balls{1};
+  size_t games{0};
+  double tickRate{Game::defaultTickRate};
+  std::string assetDir{".."};
+  bool packedVertices{false};
+  bool verbose{false};
+};
+
+// Fills options from the command line, starting from the defaults of the
+// program in options. Prints the usage and returns false on an unknown
+// option or a count that is missing, not a number or 0.
+bool parseOptions(int argc, char *argv[], Options &options);
+
+#endif // OPTIONS_H
@@ -0,0 +1,16 @@
+#include "random.h"
+
+Random::Random(uint64_t seed) : m_state(seed) {}
+
+uint64_t Random::next() {
+  uint64_t z = (m_state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+float Random::uniform(float low, float high) {
+  // top 24 bits fill the float mantissa exactly
+  float unit = (float)(next() >> 40) * (1.0f / 16777216.0f);
+  return low + (high - low) * unit;
+}
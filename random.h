@@ -0,0 +1,22 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Small random generator (splitmix64) with its whole state in one word, so
+// every game can own and copy one instead of sharing the global rand()
+// state. The same seed always gives the same sequence on every platform.
+class Random {
+public:
+  explicit Random(uint64_t seed = 0);
+
+  void seed(uint64_t seed) { m_state = seed; }
+  uint64_t next();
+  // uniform in [low, high)
+  float uniform(float low, float high);
+
+private:
+  uint64_t m_state;
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,163 @@
+#include "glad.h"
+
+#include "renderqueue.h"
+#include "transform.h"
+
+#include <algorithm>
+
+RenderQueue::RenderQueue() {}
+
+uint64_t RenderQueue::sortKey(uint32_t programId, uint32_t textureId,
+                              uint32_t meshId, float depth) {
+  // opaque geometry, front to back inside one state bucket
+  uint64_t quantizedDepth = std::clamp(depth, 0.0f, 1.0f) * 0xffff;
+
+  return (uint64_t)(programId & 0xffff) << 48 |
+         (uint64_t)(textureId & 0xffff) << 32 |
+         (uint64_t)(meshId & 0xffff) << 16 | quantizedDepth;
+}
+
+void RenderQueue::setup(uint32_t maxInstances) {
+  m_instances.setup(maxInstances);
+  glGenBuffers(1, &m_indirectBuffer);
+}
+
+void RenderQueue::beginFrame(const glm::mat4 &view, float zFar) {
+  m_view = view;
+  m_zFar = zFar;
+  m_instances.beginFrame();
+}
+
+float RenderQueue::depth(glm::vec3 position) const {
+  glm::vec4 viewPosition = m_view * glm::vec4(position, 1.0f);
+  return -viewPosition.z / m_zFar;
+}
+
+void RenderQueue::submit(const AssetRegistry &assets, const GameObject &obj) {
+  // pad and ball move every frame, caching their matrix would not pay off
+  glm::mat4 model = Transform::build(obj.movement, obj.rotation, obj.scale,
+                                     assets.mesh(obj.meshId).dequantize);
+
+  uint32_t baseInstance;
+  glm::mat4 *instance = allocateInstances(1, baseInstance);
+  if (instance == nullptr) {
+    return;
+  }
+  *instance = model;
+  submitInstanced(obj.programId, obj.textureId, obj.meshId, 1, baseInstance,
+                  depth(obj.movement));
+}
+
+glm::mat4 *RenderQueue::allocateInstances(uint32_t count,
+                                          uint32_t &baseInstance) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_instances.allocate(count, baseInstance);
+}
+
+void RenderQueue::submitInstanced(uint32_t programId, uint32_t textureId,
+                                  uint32_t meshId, uint32_t instanceCount,
+                                  uint32_t baseInstance, float depth) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_packets.push_back(DrawPacket{sortKey(programId, textureId, meshId, depth),
+                                 programId, textureId, meshId, instanceCount,
+                                 baseInstance});
+}
+
+void RenderQueue::flush(const AssetRegistry &assets) {
+  buildBatches(assets);
+  m_packets.clear();
+  m_stateChanges = 0;
+  m_drawCalls = 0;
+  if (m_commands.empty()) {
+    m_instances.endFrame();
+    return;
+  }
+  m_instances.commit();
+
+  // The command buffer is rewritten every frame while the GPU may still
+  // read last frame's commands, orphaning it gives the driver fresh storage
+  // instead of a sync stall.
+  size_t commandBytes = m_commands.size() * sizeof(DrawElementsIndirectCommand);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+  if (commandBytes > m_indirectCapacity) {
+    m_indirectCapacity = commandBytes * 2;
+  }
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, m_indirectCapacity, nullptr,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commandBytes, m_commands.data());
+
+  constexpr uint32_t unbound = 0xffffffff;
+  uint32_t programId{unbound}, textureId{unbound}, VAO{unbound};
+
+  glActiveTexture(GL_TEXTURE0);
+  for (const auto &batch : m_batches) {
+    if (batch.programId != programId) {
+      programId = batch.programId;
+      assets.program(programId).use();
+      m_stateChanges++;
+    }
+    if (batch.textureId != textureId) {
+      textureId = batch.textureId;
+      glBindTexture(GL_TEXTURE_2D, textureId);
+      m_stateChanges++;
+    }
+    if (batch.VAO != VAO) {
+      VAO = batch.VAO;
+      glBindVertexArray(VAO);
+      // the instance binding is VAO state
+      glBindVertexBuffer(instanceBinding, m_instances.buffer(), 0,
+                         sizeof(glm::mat4));
+      m_stateChanges++;
+    }
+
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES, batch.indexType,
+        (void *)(batch.firstCommand * sizeof(DrawElementsIndirectCommand)),
+        batch.commandCount, 0);
+    m_drawCalls++;
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glUseProgram(0);
+  m_instances.endFrame();
+}
+
+void RenderQueue::release() {
+  m_instances.release();
+  glDeleteBuffers(1, &m_indirectBuffer);
+  m_indirectBuffer = 0;
+  m_indirectCapacity = 0;
+}
+
+// Sorts the packets and turns them into indirect commands, starting a new
+// batch whenever program, texture or arena changes.
+void RenderQueue::buildBatches(const AssetRegistry &assets) {
+  // sort small key/index pairs instead of moving the packets around
+  m_order.clear();
+  for (uint32_t n = 0; n < m_packets.size(); n++) {
+    m_order.emplace_back(m_packets[n].key, n);
+  }
+  std::sort(m_order.begin(), m_order.end());
+
+  m_commands.clear();
+  m_batches.clear();
+  for (const auto &[key, index] : m_order) {
+    const auto &packet = m_packets[index];
+    const auto &mesh = assets.mesh(packet.meshId);
+    if (mesh.indexCount == 0) {
+      continue;
+    }
+
+    if (m_batches.empty() || m_batches.back().programId != packet.programId ||
+        m_batches.back().textureId != packet.textureId ||
+        m_batches.back().VAO != mesh.VAO) {
+      m_batches.push_back(Batch{packet.programId, packet.textureId, mesh.VAO,
+                                mesh.indexType, (uint32_t)m_commands.size(),
+                                0});
+    }
+    m_commands.push_back(DrawElementsIndirectCommand{
+        mesh.indexCount, packet.instanceCount, mesh.firstIndex,
+        mesh.baseVertex, packet.baseInstance});
+    m_batches.back().commandCount++;
+  }
+}
@@ -0,0 +1,93 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include "assetregistry.h"
+#include "gameobject.h"
+#include "instancering.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// One draw call worth of state. The sort key packs program, texture, mesh
+// (VAO) and depth from most to least expensive to switch. Model matrices
+// are read from the instance ring starting at baseInstance.
+struct DrawPacket {
+  uint64_t key;
+  uint32_t programId;
+  uint32_t textureId;
+  uint32_t meshId;
+  uint32_t instanceCount;
+  uint32_t baseInstance;
+};
+
+// Layout glMultiDrawElementsIndirect reads from the indirect buffer.
+struct DrawElementsIndirectCommand {
+  uint32_t count;
+  uint32_t instanceCount;
+  uint32_t firstIndex;
+  int32_t baseVertex;
+  uint32_t baseInstance;
+};
+
+// Collects the draws of a frame and sorts them by key. Runs of packets
+// sharing program, texture and arena VAO become one
+// glMultiDrawElementsIndirect call, GL state is only touched between runs.
+// submit(), allocateInstances() and submitInstanced() may be called from
+// several jobs at once between beginFrame() and flush(), the rest only from
+// the GL thread.
+class RenderQueue {
+public:
+  RenderQueue();
+
+  static uint64_t sortKey(uint32_t programId, uint32_t textureId,
+                          uint32_t meshId, float depth);
+
+  // maxInstances bounds the model matrices written in one frame
+  void setup(uint32_t maxInstances);
+  // camera used to compute the depth part of the keys
+  void beginFrame(const glm::mat4 &view, float zFar);
+  float depth(glm::vec3 position) const;
+
+  void submit(const AssetRegistry &assets, const GameObject &obj);
+  // room for count model matrices, fill them before flush()
+  glm::mat4 *allocateInstances(uint32_t count, uint32_t &baseInstance);
+  // ring region written this frame, its old contents are still in place
+  uint32_t instanceRegion() const { return m_instances.region(); }
+  void submitInstanced(uint32_t programId, uint32_t textureId,
+                       uint32_t meshId, uint32_t instanceCount,
+                       uint32_t baseInstance, float depth);
+  void flush(const AssetRegistry &assets);
+  void release();
+
+  // GL state changes and draw calls issued by the last flush
+  uint32_t stateChanges() const { return m_stateChanges; }
+  uint32_t drawCalls() const { return m_drawCalls; }
+
+private:
+  // consecutive commands drawn with the same state
+  struct Batch {
+    uint32_t programId;
+    uint32_t textureId;
+    uint32_t VAO;
+    uint32_t indexType;
+    uint32_t firstCommand;
+    uint32_t commandCount;
+  };
+
+  void buildBatches(const AssetRegistry &assets);
+
+  InstanceRing m_instances;
+  std::mutex m_mutex; // guards m_instances and m_packets while submitting
+  std::vector<DrawPacket> m_packets;
+  std::vector<DrawElementsIndirectCommand> m_commands;
+  std::vector<Batch> m_batches;
+  uint32_t m_indirectBuffer{0};
+  size_t m_indirectCapacity{0};
+  std::vector<std::pair<uint64_t, uint32_t>> m_order;
+  glm::mat4 m_view{1.0f};
+  float m_zFar{1.0f};
+  uint32_t m_stateChanges{0};
+  uint32_t m_drawCalls{0};
+};
+
+#endif // RENDERQUEUE_H
@@ -0,0 +1,202 @@
+#include "glad.h"
+
+#include "shaderprogram.h"
+#include "mappedfile.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+struct ProgramBinaryHeader {
+  char magic[4];
+  uint32_t format;
+  uint32_t length;
+};
+constexpr char programBinaryMagic[4] = {'B', 'O', 'P', 'B'};
+
+unsigned int loadShaders(const char *shaderSource, GLenum shaderType,
+                         const char *defines) {
+
+  unsigned int shader{0};
+  int success{0};
+  char infoLog[1024];
+
+  shader = glCreateShader(shaderType); // GL_VERTEX_SHADER
+
+  // defines have to go after the #version line
+  std::string source{shaderSource};
+  auto versionEnd = source.find('\n', source.find("#version"));
+  source.insert(versionEnd + 1, defines);
+  const char *sourcePtr = source.c_str();
+
+  glShaderSource(shader, 1, &sourcePtr, NULL);
+  glCompileShader(shader);
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+  if (!success) {
+    glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+    std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
+              << infoLog << std::endl;
+  }
+  return shader;
+}
+
+unsigned int makeShaderProgram(uint32_t vertexShader, uint32_t fragmentShader,
+                               bool &linked) {
+  unsigned int shaderProgram;
+  int success{0};
+  char infoLog[4096];
+
+  shaderProgram = glCreateProgram();
+  // lets saveBinary fetch the linked program later
+  glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                      GL_TRUE);
+  glAttachShader(shaderProgram, vertexShader);
+  glAttachShader(shaderProgram, fragmentShader);
+  glLinkProgram(shaderProgram);
+
+  glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+  if (!success) {
+    glGetProgramInfoLog(shaderProgram, 4096, NULL, infoLog);
+    std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+              << infoLog << std::endl;
+  }
+  linked = success != 0;
+
+  glDeleteShader(vertexShader);
+  glDeleteShader(fragmentShader);
+
+  return shaderProgram;
+}
+} // namespace
+
+ShaderProgram::ShaderProgram() {}
+
+bool ShaderProgram::build(const char *vertexSource, const char *fragmentSource,
+                          const char *defines) {
+  auto vertexShader = loadShaders(vertexSource, GL_VERTEX_SHADER, defines);
+  auto fragmentShader =
+      loadShaders(fragmentSource, GL_FRAGMENT_SHADER, defines);
+
+  bool linked{false};
+  m_id = makeShaderProgram(vertexShader, fragmentShader, linked);
+  resolveUniforms();
+
+  return linked;
+}
+
+bool ShaderProgram::loadBinary(const std::string &filename) {
+  MappedFile file(filename);
+  if (!file.isOpen()) {
+    return false;
+  }
+
+  auto data = file.data();
+  ProgramBinaryHeader header;
+  if (data.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (std::memcmp(header.magic, programBinaryMagic,
+                  sizeof(programBinaryMagic)) != 0 ||
+      data.size() != sizeof(header) + header.length) {
+    return false;
+  }
+
+  uint32_t program = glCreateProgram();
+  glProgramBinary(program, header.format, data.data() + sizeof(header),
+                  header.length);
+
+  int success{0};
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+  if (!success) {
+    // binary from another driver or GPU, caller compiles from source
+    glDeleteProgram(program);
+    return false;
+  }
+
+  m_id = program;
+  resolveUniforms();
+  return true;
+}
+
+bool ShaderProgram::saveBinary(const std::string &filename) const {
+  int length{0};
+  glGetProgramiv(m_id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return false;
+  }
+
+  std::vector<char> binary(length);
+  GLenum format{0};
+  glGetProgramBinary(m_id, length, nullptr, &format, binary.data());
+
+  ProgramBinaryHeader header;
+  std::memcpy(header.magic, programBinaryMagic, sizeof(programBinaryMagic));
+  header.format = format;
+  header.length = length;
+
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(binary.data(), binary.size());
+
+  return (bool)file;
+}
+
+void ShaderProgram::release() {
+  glDeleteProgram(m_id);
+  m_id = 0;
+  m_active.clear();
+}
+
+void ShaderProgram::use() const { glUseProgram(m_id); }
+
+int32_t ShaderProgram::location(std::string_view name) const {
+  for (const auto &uniform : m_active) {
+    if (uniform.name == name) {
+      return uniform.location;
+    }
+  }
+  return -1;
+}
+
+void ShaderProgram::set(std::string_view name, int32_t value) const {
+  auto loc = location(name);
+  if (loc >= 0) {
+    glProgramUniform1i(m_id, loc, value);
+  }
+}
+
+void ShaderProgram::resolveUniforms() {
+  m_active.clear();
+
+  int count{0}, maxLength{0};
+  glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+  std::vector<char> name(maxLength + 1);
+  for (int index = 0; index < count; index++) {
+    GLsizei length{0};
+    GLint size{0};
+    GLenum type{0};
+    glGetActiveUniform(m_id, index, name.size(), &length, &size, &type,
+                       name.data());
+
+    ActiveUniform uniform;
+    uniform.name.assign(name.data(), length);
+    // arrays are reported as "name[0]"
+    if (uniform.name.size() > 3 &&
+        uniform.name.compare(uniform.name.size() - 3, 3, "[0]") == 0) {
+      uniform.name.resize(uniform.name.size() - 3);
+    }
+    uniform.location = glGetUniformLocation(m_id, name.data());
+    if (uniform.location < 0) {
+      continue; // member of a uniform block
+    }
+    m_active.push_back(std::move(uniform));
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef SHADERPROGRAM_H
+#define SHADERPROGRAM_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Linked GL program plus a table of its active uniforms built right after
+// linking, so setting a uniform never asks the driver for a location. Camera
+// state comes from the Frame uniform block instead, see frameuniforms.h.
+class ShaderProgram {
+public:
+  ShaderProgram();
+
+  bool build(const char *vertexSource, const char *fragmentSource,
+             const char *defines = "");
+  // glProgramBinary round trip, loading fails when the driver changed
+  bool loadBinary(const std::string &filename);
+  bool saveBinary(const std::string &filename) const;
+  void release();
+
+  uint32_t id() const { return m_id; }
+  void use() const;
+
+  // sampler units and other int uniforms, ignored when name is not active
+  void set(std::string_view name, int32_t value) const;
+
+private:
+  struct ActiveUniform {
+    std::string name;
+    int32_t location;
+  };
+
+  void resolveUniforms();
+  // searches the table built at link time, -1 when there is no such uniform
+  int32_t location(std::string_view name) const;
+
+  uint32_t m_id{0};
+  std::vector<ActiveUniform> m_active;
+};
+
+#endif // SHADERPROGRAM_H
@@ -0,0 +1,89 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(uint32_t threads) {
+  for (uint32_t n = 1; n < threads; n++) {
+    m_workers.emplace_back([this] { worker(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (auto &thread : m_workers) {
+    thread.join();
+  }
+}
+
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t)> &task) {
+  if (count == 0) {
+    return;
+  }
+  if (m_workers.empty() || count == 1) {
+    for (size_t index = 0; index < count; index++) {
+      task(index);
+    }
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // a worker still leaving the previous batch must not pick up new indices
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_task = &task;
+    m_count = count;
+    m_next = 0;
+    m_pending = count;
+    m_generation++;
+  }
+  m_wake.notify_all();
+
+  runTasks(task, count);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this] { return m_pending == 0; });
+  m_task = nullptr;
+}
+
+void ThreadPool::worker() {
+  uint64_t seenGeneration{0};
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (true) {
+    m_wake.wait(lock,
+                [&] { return m_stop || m_generation != seenGeneration; });
+    if (m_stop) {
+      return;
+    }
+    seenGeneration = m_generation;
+    if (m_task == nullptr) {
+      continue;
+    }
+
+    const auto *task = m_task;
+    size_t count = m_count;
+    m_busy++;
+    lock.unlock();
+
+    runTasks(*task, count);
+
+    lock.lock();
+    m_busy--;
+    m_done.notify_all();
+  }
+}
+
+void ThreadPool::runTasks(const std::function<void(size_t)> &task,
+                          size_t count) {
+  size_t index;
+  while ((index = m_next.fetch_add(1)) < count) {
+    task(index);
+    if (m_pending.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_done.notify_all();
+    }
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running index ranges. The calling thread
+// takes part in the work, so a pool of size 1 runs everything inline.
+class ThreadPool {
+public:
+  ThreadPool(uint32_t threads = std::thread::hardware_concurrency());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // threads working on a parallelFor, including the caller
+  uint32_t size() const { return m_workers.size() + 1; }
+
+  // runs task(0) .. task(count - 1) and returns when all have finished
+  void parallelFor(size_t count, const std::function<void(size_t)> &task);
+
+private:
+  void worker();
+  void runTasks(const std::function<void(size_t)> &task, size_t count);
+
+  std::vector<std::thread> m_workers;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+
+  const std::function<void(size_t)> *m_task{nullptr};
+  size_t m_count{0};
+  std::atomic<size_t> m_next{0};
+  std::atomic<size_t> m_pending{0};
+  uint64_t m_generation{0};
+  uint32_t m_busy{0};
+  bool m_stop{false};
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,40 @@
+#include "transform.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+Transform::Transform() {}
+
+glm::mat4 Transform::build(const glm::vec3 &movement,
+                           const glm::vec3 &rotation, const glm::vec3 &scale,
+                           const glm::mat4 &local) {
+  glm::mat4 model = glm::mat4(1.0f);
+  model = glm::translate(model, movement);
+  if (rotation != glm::vec3(0.0f)) {
+    model = glm::rotate(model, rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+    model = glm::rotate(model, rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::rotate(model, rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+  }
+  model = glm::scale(model, scale);
+
+  return model * local;
+}
+
+void Transform::setLocal(const glm::mat4 &local) {
+  m_local = local;
+  m_valid = false;
+}
+
+bool Transform::update(const glm::vec3 &movement, const glm::vec3 &rotation,
+                       const glm::vec3 &scale) {
+  if (m_valid && movement == m_movement && rotation == m_rotation &&
+      scale == m_scale) {
+    return false;
+  }
+  m_movement = movement;
+  m_rotation = rotation;
+  m_scale = scale;
+  m_matrix = build(movement, rotation, scale, m_local);
+  m_valid = true;
+
+  return true;
+}
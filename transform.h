@@ -0,0 +1,32 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <glm/glm.hpp>
+
+// Caches the model matrix of an object and only rebuilds it when movement,
+// rotation (euler angles in radians) or scale differ from the values it was
+// last built from.
+class Transform {
+public:
+  Transform();
+
+  static glm::mat4 build(const glm::vec3 &movement, const glm::vec3 &rotation,
+                         const glm::vec3 &scale, const glm::mat4 &local);
+
+  // applied before the object transform, e.g. a mesh dequantize matrix
+  void setLocal(const glm::mat4 &local);
+  // returns true when the matrix had to be rebuilt
+  bool update(const glm::vec3 &movement, const glm::vec3 &rotation,
+              const glm::vec3 &scale);
+  const glm::mat4 &matrix() const { return m_matrix; }
+
+private:
+  glm::vec3 m_movement{0.0f};
+  glm::vec3 m_rotation{0.0f};
+  glm::vec3 m_scale{0.0f};
+  glm::mat4 m_local{1.0f};
+  glm::mat4 m_matrix{1.0f};
+  bool m_valid{false};
+};
+
+#endif // TRANSFORM_H
@@ -0,0 +1,63 @@
+#include "vertexdedup.h"
+
+namespace {
+// keep at most 7 of 10 slots in use so probe chains stay short
+size_t capacityFor(size_t count) {
+  size_t capacity = 16;
+  while (capacity * 7 < count * 10) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+} // namespace
+
+VertexDedup::VertexDedup(size_t expectedVertices) {
+  m_slots.resize(capacityFor(expectedVertices));
+  m_mask = m_slots.size() - 1;
+}
+
+std::pair<uint32_t, bool> VertexDedup::insert(uint32_t v, uint32_t vt,
+                                              uint32_t vn, uint32_t newIndex) {
+  if ((m_size + 1) * 10 > m_slots.size() * 7) {
+    grow();
+  }
+
+  size_t pos = hash(v, vt, vn) & m_mask;
+  while (true) {
+    auto &slot = m_slots[pos];
+    if (slot.index == emptySlot) {
+      slot = Slot{v, vt, vn, newIndex};
+      m_size++;
+      return {newIndex, true};
+    }
+    if (slot.v == v && slot.vt == vt && slot.vn == vn) {
+      return {slot.index, false};
+    }
+    pos = (pos + 1) & m_mask;
+  }
+}
+
+uint64_t VertexDedup::hash(uint32_t v, uint32_t vt, uint32_t vn) {
+  uint64_t h = v * 0x9E3779B97F4A7C15ull;
+  h ^= vt * 0xC2B2AE3D27D4EB4Full;
+  h ^= vn * 0x165667B19E3779F9ull;
+  return h ^ (h >> 29);
+}
+
+void VertexDedup::grow() {
+  std::vector<Slot> old;
+  old.swap(m_slots);
+  m_slots.resize(old.size() * 2);
+  m_mask = m_slots.size() - 1;
+
+  for (const auto &slot : old) {
+    if (slot.index == emptySlot) {
+      continue;
+    }
+    size_t pos = hash(slot.v, slot.vt, slot.vn) & m_mask;
+    while (m_slots[pos].index != emptySlot) {
+      pos = (pos + 1) & m_mask;
+    }
+    m_slots[pos] = slot;
+  }
+}
@@ -0,0 +1,40 @@
+#ifndef VERTEXDEDUP_H
+#define VERTEXDEDUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Maps a face corner (v, vt, vn) index triple to the mesh vertex created
+// for it. Open addressing with linear probing in one flat array, sized up
+// front so loading a mesh normally never rehashes.
+class VertexDedup {
+public:
+  VertexDedup(size_t expectedVertices);
+
+  // returns the vertex index stored for the triple and false, or stores
+  // newIndex for it and returns newIndex and true
+  std::pair<uint32_t, bool> insert(uint32_t v, uint32_t vt, uint32_t vn,
+                                   uint32_t newIndex);
+  size_t size() const { return m_size; }
+
+private:
+  static constexpr uint32_t emptySlot = 0xffffffff;
+
+  struct Slot {
+    uint32_t v;
+    uint32_t vt;
+    uint32_t vn;
+    uint32_t index{emptySlot};
+  };
+
+  static uint64_t hash(uint32_t v, uint32_t vt, uint32_t vn);
+  void grow();
+
+  std::vector<Slot> m_slots;
+  size_t m_mask{0};
+  size_t m_size{0};
+};
+
+#endif // VERTEXDEDUP_H
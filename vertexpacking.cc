@@ -0,0 +1,122 @@
+#include "vertexpacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace {
+glm::vec3 boundsExtent(glm::vec3 boundsMin, glm::vec3 boundsMax) {
+  glm::vec3 extent = boundsMax - boundsMin;
+  // flat meshes still need a non zero scale
+  for (int axis = 0; axis < 3; axis++) {
+    if (extent[axis] <= 0.0f) {
+      extent[axis] = 1.0f;
+    }
+  }
+  return extent;
+}
+
+float signNotZero(float value) { return value >= 0.0f ? 1.0f : -1.0f; }
+
+glm::vec2 octEncode(glm::vec3 normal) {
+  float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+  if (sum == 0.0f) {
+    return glm::vec2(0.0f, 0.0f);
+  }
+  normal = normal / sum;
+  if (normal.z < 0.0f) {
+    return glm::vec2((1.0f - std::fabs(normal.y)) * signNotZero(normal.x),
+                     (1.0f - std::fabs(normal.x)) * signNotZero(normal.y));
+  }
+  return glm::vec2(normal.x, normal.y);
+}
+
+// same as octDecode in the packed vertex shader
+glm::vec3 octDecode(glm::vec2 encoded) {
+  glm::vec3 normal(encoded.x, encoded.y,
+                   1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+  float t = std::max(-normal.z, 0.0f);
+  normal.x += normal.x >= 0.0f ? -t : t;
+  normal.y += normal.y >= 0.0f ? -t : t;
+  return glm::normalize(normal);
+}
+} // namespace
+
+glm::mat4 dequantizeMatrix(glm::vec3 boundsMin, glm::vec3 boundsMax) {
+  glm::mat4 dequantize = glm::translate(glm::mat4(1.0f), boundsMin);
+  return glm::scale(dequantize, boundsExtent(boundsMin, boundsMax));
+}
+
+std::vector<PackedVertex> packVertices(const Vertex *vertices, size_t count,
+                                       glm::vec3 boundsMin,
+                                       glm::vec3 boundsMax) {
+  glm::vec3 extent = boundsExtent(boundsMin, boundsMax);
+  std::vector<PackedVertex> packed(count);
+
+  for (size_t n = 0; n < count; n++) {
+    const auto &vertex = vertices[n];
+    auto &out = packed[n];
+
+    glm::vec3 relative = (vertex.Coord - boundsMin) / extent;
+    for (int axis = 0; axis < 3; axis++) {
+      out.Coord[axis] = glm::packUnorm1x16(relative[axis]);
+    }
+    out.Coord[3] = 0;
+
+    glm::vec2 normal = octEncode(vertex.Normal);
+    out.Normal[0] = glm::packSnorm1x16(normal.x);
+    out.Normal[1] = glm::packSnorm1x16(normal.y);
+
+    out.TextureCoords[0] = glm::packHalf1x16(vertex.TextureCoords.x);
+    out.TextureCoords[1] = glm::packHalf1x16(vertex.TextureCoords.y);
+  }
+
+  return packed;
+}
+
+Vertex unpackVertex(const PackedVertex &packed, glm::vec3 boundsMin,
+                    glm::vec3 boundsMax) {
+  glm::vec3 extent = boundsExtent(boundsMin, boundsMax);
+  Vertex vertex;
+
+  glm::vec3 relative(glm::unpackUnorm1x16(packed.Coord[0]),
+                     glm::unpackUnorm1x16(packed.Coord[1]),
+                     glm::unpackUnorm1x16(packed.Coord[2]));
+  vertex.Coord = boundsMin + relative * extent;
+  vertex.Normal = octDecode(glm::vec2(glm::unpackSnorm1x16(packed.Normal[0]),
+                                      glm::unpackSnorm1x16(packed.Normal[1])));
+  vertex.TextureCoords =
+      glm::vec2(glm::unpackHalf1x16(packed.TextureCoords[0]),
+                glm::unpackHalf1x16(packed.TextureCoords[1]));
+
+  return vertex;
+}
+
+QuantizationError measureQuantization(const Vertex *vertices,
+                                      const PackedVertex *packed, size_t count,
+                                      glm::vec3 boundsMin,
+                                      glm::vec3 boundsMax) {
+  QuantizationError error;
+
+  for (size_t n = 0; n < count; n++) {
+    const auto &original = vertices[n];
+    auto unpacked = unpackVertex(packed[n], boundsMin, boundsMax);
+
+    error.position = std::max(
+        error.position, glm::length(unpacked.Coord - original.Coord));
+    error.textureCoords =
+        std::max(error.textureCoords,
+                 glm::length(unpacked.TextureCoords - original.TextureCoords));
+
+    float length = glm::length(original.Normal);
+    if (length > 0.0f) {
+      float cosine = glm::clamp(
+          glm::dot(unpacked.Normal, original.Normal / length), -1.0f, 1.0f);
+      error.normalDegrees =
+          std::max(error.normalDegrees, std::acos(cosine) * 57.2957795f);
+    }
+  }
+
+  return error;
+}
@@ -0,0 +1,29 @@
+#ifndef VERTEXPACKING_H
+#define VERTEXPACKING_H
+
+#include "mesh.h"
+#include <cstddef>
+#include <vector>
+
+// Largest round trip error of a packed mesh, positions in model units,
+// normals in degrees and texture coordinates in UV units.
+struct QuantizationError {
+  float position{0};
+  float normalDegrees{0};
+  float textureCoords{0};
+};
+
+// Positions are stored relative to the bounds, the returned matrix maps
+// them back to model space and is folded into the model matrix.
+glm::mat4 dequantizeMatrix(glm::vec3 boundsMin, glm::vec3 boundsMax);
+
+std::vector<PackedVertex> packVertices(const Vertex *vertices, size_t count,
+                                       glm::vec3 boundsMin,
+                                       glm::vec3 boundsMax);
+Vertex unpackVertex(const PackedVertex &packed, glm::vec3 boundsMin,
+                    glm::vec3 boundsMax);
+QuantizationError measureQuantization(const Vertex *vertices,
+                                      const PackedVertex *packed, size_t count,
+                                      glm::vec3 boundsMin, glm::vec3 boundsMax);
+
+#endif // VERTEXPACKING_H
@@ -1,116 +1,323 @@
 #include "wavefrontreader.h"
+#include "mappedfile.h"
+#include "threadpool.h"
+#include "vertexdedup.h"
 
-#include <array>
-#include <cassert>
-#include <fstream>
+#include <algorithm>
+#include <charconv>
 #include <iostream>
-#include <sstream>
 #include <string>
-#include <unordered_map>
 
-WaveFrontReader::WaveFrontReader(std::string filename) : m_filename(filename) {}
+namespace {
+// Cursor over one line of the file buffer, the parse helpers below never
+// allocate, they only move `pos` forward.
+struct LineScanner {
+  const char *pos;
+  const char *end;
 
-void WaveFrontReader::readVertices(Mesh &obj) {
-  std::ifstream myfile(m_filename);
-  std::string line;
-  uint32_t vertexIndex{0};
+  void skipSpaces() {
+    while (pos < end && (*pos == ' ' || *pos == '\t')) {
+      pos++;
+    }
+  }
+
+  bool atEnd() {
+    skipSpaces();
+    return pos >= end;
+  }
+
+  float readFloat() {
+    skipSpaces();
+    if (pos < end && *pos == '+') { // from_chars does not accept a plus sign
+      pos++;
+    }
+    float value{0.0f};
+    auto [ptr, ec] = std::from_chars(pos, end, value);
+    if (ec == std::errc()) {
+      pos = ptr;
+    }
+    return value;
+  }
+
+  int64_t readIndex() {
+    int64_t value{0};
+    auto [ptr, ec] = std::from_chars(pos, end, value);
+    if (ec == std::errc()) {
+      pos = ptr;
+    }
+    return value;
+  }
+
+  // skips the rest of the current token, used for malformed input
+  void skipToken() {
+    while (pos < end && *pos != ' ' && *pos != '\t') {
+      pos++;
+    }
+  }
+};
+
+// One face corner as written in the file. Indices are 1-based, OBJ
+// relative (negative) indices are stored as a position relative to the
+// start of the chunk, which may point into an earlier chunk, and get the
+// chunk offset added on merge.
+struct Corner {
+  enum : uint8_t { RelativeV = 1, RelativeVt = 2, RelativeVn = 4 };
+
+  int64_t v{0};
+  int64_t vt{0};
+  int64_t vn{0};
+  uint8_t relative{0};
+};
+
+struct Chunk {
   std::vector<glm::vec3> vertices;
   std::vector<glm::vec2> textureCoords;
   std::vector<glm::vec3> normals;
-  std::unordered_map<uint64_t, uint32_t> faces;
+  std::vector<Corner> corners;
   float xMax{-10000.0f}, xMin{10000.0f}, yMax{-10000.0f}, yMin{10000.0f};
+  glm::vec3 boundsMin{0.0f}, boundsMax{0.0f};
+};
 
-  if (myfile.is_open()) {
-    while (getline(myfile, line)) {
-      auto vpos = line.find("v ");
-      if (vpos == 0) {
-        std::stringstream conv{line.substr(1)};
-        float x, y, z;
-        conv >> x >> y >> z;
-        // std::cout << "v x " << x << " y " << y << " z " << z << std::endl;
-        vertices.push_back(glm::vec3(x, y, z));
-        xMax = (xMax > x) ? xMax : x;
-        xMin = (xMin < x) ? xMin : x;
-
-        yMax = (yMax > x) ? yMax : x;
-        yMin = (yMin < x) ? yMin : x;
+int64_t resolveIndex(int64_t index, size_t localCount, uint8_t flag,
+                     uint8_t &relative) {
+  if (index < 0) {
+    relative |= flag;
+    return (int64_t)localCount + index + 1;
+  }
+  return index;
+}
 
-        continue;
+uint64_t globalIndex(int64_t index, bool relative, size_t offset) {
+  if (relative) {
+    index += (int64_t)offset;
+    return index > 0 ? index : 0;
+  }
+  return index;
+}
+
+void parseChunk(std::string_view buffer, Chunk &chunk) {
+  const char *pos = buffer.data();
+  const char *end = pos + buffer.size();
+
+  while (pos < end) {
+    const char *lineEnd = pos;
+    while (lineEnd < end && *lineEnd != '\n') {
+      lineEnd++;
+    }
+    const char *next = lineEnd < end ? lineEnd + 1 : end;
+    if (lineEnd > pos && lineEnd[-1] == '\r') {
+      lineEnd--;
+    }
+    LineScanner line{pos, lineEnd};
+    pos = next;
+
+    if (lineEnd - line.pos < 2) {
+      continue;
+    }
+
+    if (line.pos[0] == 'v' && line.pos[1] == ' ') {
+      line.pos += 2;
+      float x = line.readFloat();
+      float y = line.readFloat();
+      float z = line.readFloat();
+      chunk.vertices.push_back(glm::vec3(x, y, z));
+      if (chunk.vertices.size() == 1) {
+        chunk.boundsMin = chunk.boundsMax = chunk.vertices.back();
+      } else {
+        chunk.boundsMin = glm::min(chunk.boundsMin, chunk.vertices.back());
+        chunk.boundsMax = glm::max(chunk.boundsMax, chunk.vertices.back());
       }
-      vpos = line.find("vt ");
-      if (vpos == 0) {
-        std::stringstream conv{line.substr(2)};
-        float x, y;
-        conv >> x >> y;
-        // std::cout << "vt x " << x << " y " << y << std::endl;
-        textureCoords.push_back(glm::vec2(x, -y));
-        continue;
+      chunk.xMax = (chunk.xMax > x) ? chunk.xMax : x;
+      chunk.xMin = (chunk.xMin < x) ? chunk.xMin : x;
+
+      chunk.yMax = (chunk.yMax > x) ? chunk.yMax : x;
+      chunk.yMin = (chunk.yMin < x) ? chunk.yMin : x;
+
+      continue;
+    }
+    if (line.pos[0] == 'v' && line.pos[1] == 't' &&
+        (lineEnd - line.pos > 2 && line.pos[2] == ' ')) {
+      line.pos += 3;
+      float x = line.readFloat();
+      float y = line.readFloat();
+      chunk.textureCoords.push_back(glm::vec2(x, -y));
+      continue;
+    }
+    if (line.pos[0] == 'v' && line.pos[1] == 'n' &&
+        (lineEnd - line.pos > 2 && line.pos[2] == ' ')) {
+      line.pos += 3;
+      float x = line.readFloat();
+      float y = line.readFloat();
+      float z = line.readFloat();
+      chunk.normals.push_back(glm::vec3(x, y, z));
+      continue;
+    }
+    if (line.pos[0] == 'f' && line.pos[1] == ' ') {
+      // f 1/2/3 1/2/3 13/1/2
+      // f 11/108/34 13/109/34 7/106/34
+      line.pos += 2;
+
+      while (!line.atEnd()) {
+        Corner corner;
+        corner.v = resolveIndex(line.readIndex(), chunk.vertices.size(),
+                                Corner::RelativeV, corner.relative);
+        if (line.pos < line.end && *line.pos == '/') { // get index for texture
+          line.pos++;
+          corner.vt = resolveIndex(line.readIndex(), chunk.textureCoords.size(),
+                                   Corner::RelativeVt, corner.relative);
+        }
+        if (line.pos < line.end && *line.pos == '/') { // get index for normal
+          line.pos++;
+          corner.vn = resolveIndex(line.readIndex(), chunk.normals.size(),
+                                   Corner::RelativeVn, corner.relative);
+        }
+        line.skipToken();
+        chunk.corners.push_back(corner);
       }
-      vpos = line.find("vn ");
-      if (vpos == 0) {
+    }
+  }
+}
 
-        std::stringstream conv{line.substr(2)};
-        float x, y, z;
-        conv >> x >> y >> z;
-        // std::cout << "vn x " << x << " y " << y << std::endl;
-        normals.push_back(glm::vec3(x, y, z));
+// Concatenates the chunk attributes in file order and builds the indexed
+// mesh, so the result does not depend on how the file was split.
+void mergeChunks(std::vector<Chunk> &chunks, Mesh &obj) {
+  std::vector<glm::vec3> vertices;
+  std::vector<glm::vec2> textureCoords;
+  std::vector<glm::vec3> normals;
+  size_t cornerCount{0};
+  float xMax{-10000.0f}, xMin{10000.0f}, yMax{-10000.0f}, yMin{10000.0f};
+  glm::vec3 boundsMin{0.0f}, boundsMax{0.0f};
+  bool haveBounds{false};
+
+  for (auto &chunk : chunks) {
+    vertices.insert(vertices.end(), chunk.vertices.begin(),
+                    chunk.vertices.end());
+    textureCoords.insert(textureCoords.end(), chunk.textureCoords.begin(),
+                         chunk.textureCoords.end());
+    normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+    cornerCount += chunk.corners.size();
+
+    xMax = std::max(xMax, chunk.xMax);
+    xMin = std::min(xMin, chunk.xMin);
+    yMax = std::max(yMax, chunk.yMax);
+    yMin = std::min(yMin, chunk.yMin);
+    if (!chunk.vertices.empty()) {
+      boundsMin = haveBounds ? glm::min(boundsMin, chunk.boundsMin)
+                             : chunk.boundsMin;
+      boundsMax = haveBounds ? glm::max(boundsMax, chunk.boundsMax)
+                             : chunk.boundsMax;
+      haveBounds = true;
+    }
+  }
 
+  uint32_t vertexIndex{0};
+  // a closed triangle mesh has roughly as many unique vertices as faces
+  VertexDedup faces(cornerCount / 3);
+  size_t vertexOffset{0}, textureOffset{0}, normalOffset{0};
+
+  obj.indicies.reserve(cornerCount);
+  for (auto &chunk : chunks) {
+    for (const auto &corner : chunk.corners) {
+      uint64_t indexV = globalIndex(
+          corner.v, corner.relative & Corner::RelativeV, vertexOffset);
+      uint64_t indexVt = globalIndex(
+          corner.vt, corner.relative & Corner::RelativeVt, textureOffset);
+      uint64_t indexVn = globalIndex(
+          corner.vn, corner.relative & Corner::RelativeVn, normalOffset);
+
+      if (indexV == 0 || indexV > vertices.size()) {
         continue;
       }
-      vpos = line.find("f ");
-      if (vpos == 0) {
-        // f 1/2/3 1/2/3 13/1/2
-        // f 11/108/34 13/109/34 7/106/34
-        std::istringstream splitter{line.substr(2)};
-        // std::cout << line << std::endl;
-        std::string face;
-
-        Vertex vert;
-        while (std::getline(splitter, face, ' ')) {
-          uint64_t indexV{0}, indexVt{0}, indexVn{0};
-
-          // std::cout << face << std::endl;
-          auto start_pos = face.find('/'); // get index for vertex
-          indexV = std::stoul(face.substr(0, start_pos), nullptr);
-          vert.Coord = vertices[indexV - 1];
-          auto end_pos = face.find('/', start_pos + 1); // get index for texture
-          if (start_pos != end_pos - 1) {
-            indexVt = std::stoul(
-                face.substr(start_pos + 1, end_pos - (start_pos + 1)), nullptr);
-            obj.texture_indicies.push_back((uint32_t)indexVt - 1);
-            vert.TextureCoords = textureCoords[indexVt - 1];
-          }
-          if (start_pos != end_pos - 1) { // get index for normal
-            indexVn = std::stoul(face.substr(end_pos + 1), nullptr);
-            obj.normal_indicies.push_back((uint32_t)indexVn - 1);
-            vert.Normal = normals[indexVn - 1];
-          }
-          uint64_t faceKey = indexV | indexVt << 16;
-          auto foundPos = faces.find(faceKey);
-          if (foundPos != faces.end()) {
-            obj.indicies.push_back(faces[faceKey]);
-          } else {
-            faces[faceKey] = vertexIndex;
-            obj.vertices.push_back(vert);
-            obj.indicies.push_back(vertexIndex);
-            vertexIndex++;
-          }
-        }
+      Vertex vert{};
+      vert.Coord = vertices[indexV - 1];
+      if (indexVt != 0 && indexVt <= textureCoords.size()) {
+        obj.texture_indicies.push_back((uint32_t)indexVt - 1);
+        vert.TextureCoords = textureCoords[indexVt - 1];
+      }
+      if (indexVn != 0 && indexVn <= normals.size()) {
+        obj.normal_indicies.push_back((uint32_t)indexVn - 1);
+        vert.Normal = normals[indexVn - 1];
+      }
+
+      // corners missing vt or vn keep 0 for it in the key
+      auto [foundIndex, inserted] =
+          faces.insert(indexV, indexVt <= textureCoords.size() ? indexVt : 0,
+                       indexVn <= normals.size() ? indexVn : 0, vertexIndex);
+      if (!inserted) {
+        obj.indicies.push_back(foundIndex);
+      } else {
+        obj.vertices.push_back(vert);
+        obj.indicies.push_back(vertexIndex);
+        vertexIndex++;
       }
     }
-    obj.height = yMax - yMin;
-    obj.width = xMax - xMin;
-    /*    for (const auto &vert : obj.vertices) {
-          std::cout << "v x " << vert.Coord.x << " y " << vert.Coord.y << " z "
-                    << vert.Coord.z << std::endl;
-        }
-        for (const auto &index : obj.indicies) {
-          std::cout << "index " << index << std::endl;
-        }
-    */
-    obj.indicies.shrink_to_fit();
-    obj.vertices.shrink_to_fit();
-    myfile.close();
-  } else
-    std::cout << "Unable to open file";
+    vertexOffset += chunk.vertices.size();
+    textureOffset += chunk.textureCoords.size();
+    normalOffset += chunk.normals.size();
+    // release the chunk as soon as it is merged to keep the peak low
+    chunk = Chunk();
+  }
+  obj.height = yMax - yMin;
+  obj.width = xMax - xMin;
+  obj.boundsMin = boundsMin;
+  obj.boundsMax = boundsMax;
+
+  obj.indicies.shrink_to_fit();
+  obj.vertices.shrink_to_fit();
+}
+
+// splits the buffer into roughly equal pieces ending on a newline
+std::vector<std::string_view> splitLines(std::string_view buffer,
+                                         size_t count) {
+  std::vector<std::string_view> pieces;
+  size_t step = buffer.size() / count + 1;
+  size_t start{0};
+  while (start < buffer.size()) {
+    size_t stop = std::min(start + step, buffer.size());
+    if (stop < buffer.size()) {
+      auto newline = buffer.find('\n', stop);
+      stop = newline == std::string_view::npos ? buffer.size() : newline + 1;
+    }
+    pieces.push_back(buffer.substr(start, stop - start));
+    start = stop;
+  }
+  return pieces;
+}
+} // namespace
+
+WaveFrontReader::WaveFrontReader(std::string filename) : m_filename(filename) {}
+
+bool WaveFrontReader::readVertices(Mesh &obj) {
+  // parsed straight out of the page cache when the file can be mapped
+  MappedFile myfile(m_filename);
+
+  if (!myfile.isOpen()) {
+    std::cout << "Unable to open file " << m_filename << std::endl;
+    return false;
+  }
+
+  std::vector<Chunk> chunks(1);
+  parseChunk(myfile.data(), chunks[0]);
+  mergeChunks(chunks, obj);
+  return true;
+}
+
+bool WaveFrontReader::readVertices(Mesh &obj, ThreadPool &pool) {
+  MappedFile myfile(m_filename);
+
+  if (!myfile.isOpen()) {
+    std::cout << "Unable to open file " << m_filename << std::endl;
+    return false;
+  }
+
+  auto buffer = myfile.data();
+  size_t chunkCount = std::min<size_t>(pool.size() * 2,
+                                       buffer.size() / minChunkSize + 1);
+  auto pieces = splitLines(buffer, chunkCount);
+
+  std::vector<Chunk> chunks(pieces.size());
+  pool.parallelFor(pieces.size(),
+                   [&](size_t index) { parseChunk(pieces[index], chunks[index]); });
+  mergeChunks(chunks, obj);
+  return true;
 }
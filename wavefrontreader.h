@@ -1,17 +1,27 @@
 #ifndef WAVEFRONTREADER_H
 #define WAVEFRONTREADER_H
 
+#include <cstddef>
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
 
 #include "mesh.h"
 
+class ThreadPool;
+
 class WaveFrontReader {
 public:
+  // files smaller than this are not worth splitting across threads
+  static constexpr size_t minChunkSize = 1 << 20;
+
   WaveFrontReader(std::string filename);
 
-  void readVertices(Mesh &obj);
+  // false when the file cannot be opened, obj is left as it was
+  bool readVertices(Mesh &obj);
+  // splits big files into newline aligned chunks parsed on the pool,
+  // the resulting mesh is identical to the single threaded one
+  bool readVertices(Mesh &obj, ThreadPool &pool);
 
 private:
   std::string m_filename;